@@ -0,0 +1,463 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-cache.c
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 같은 파일을 여러 번 열 때, 섹션의 압축을 풀고 레코드를 훑는 일을
+ * 반복하지 않도록 레코드 인덱스와 (선택적으로) 압축을 푼 섹션을 캐시
+ * 디렉토리에 저장한다. 캐시 파일은 그대로 mmap 해서 쓸 수 있는 형식이다.
+ *
+ *   GHWPCacheHeader
+ *   GHWPCacheSection  x n_sections
+ *   records, paragraphs, page_marks, data (섹션마다, 8바이트 정렬)
+ *
+ * 캐시 파일은 만든 호스트의 바이트 순서를 따르며, 바이트 순서가 다르면
+ * 쓰지 않는다.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "ghwp-cache.h"
+#include "ghwp-private.h"
+
+#define GHWP_CACHE_MAGIC       "GHWPIDX"
+#define GHWP_CACHE_VERSION     3
+#define GHWP_CACHE_BYTE_ORDER  0x01020304
+#define GHWP_CACHE_ALIGN(n)    (((n) + 7) & ~((guint64) 7))
+
+typedef struct _GHWPCacheHeader  GHWPCacheHeader;
+typedef struct _GHWPCacheSection GHWPCacheSection;
+
+struct _GHWPCacheHeader
+{
+    gchar    magic[8];
+    guint32  byte_order;
+    guint32  version;
+    guint32  n_sections;
+    guint32  reserved;
+};
+
+struct _GHWPCacheSection
+{
+    guint64  records_offset;
+    guint64  n_records;
+    guint64  paragraphs_offset;
+    guint64  n_paragraphs;
+    guint64  page_marks_offset;
+    guint64  n_page_marks;
+    guint64  section_size; /* 압축을 푼 섹션의 크기 */
+    guint32  page_h_size;  /* 용지 크기, 섹션을 풀지 않고 페이지 표를 만든다 */
+    guint32  page_v_size;
+    guint64  data_offset;
+    guint64  data_size;  /* 0 이면 섹션 데이터를 저장하지 않았다 */
+};
+
+G_LOCK_DEFINE_STATIC (cache);
+static gchar          *cache_directory = NULL;
+static GHWPCacheFlags  cache_flags     = 0;
+
+/**
+ * ghwp_cache_set_directory:
+ * @directory: (allow-none): a directory for cache files, or %NULL
+ * @flags: what to store, a combination of #GHWPCacheFlags
+ *
+ * Enables the on-disk cache. When a file opened by filename is found in
+ * the cache, its record indexes (and, with %GHWP_CACHE_SECTIONS, its
+ * decompressed sections) are mapped from the cache instead of being
+ * rebuilt. Entries are keyed by the file size, the modification time and
+ * a hash of the FileHeader and DocInfo streams. Passing %NULL disables
+ * the cache.
+ */
+void ghwp_cache_set_directory (const gchar *directory, GHWPCacheFlags flags)
+{
+    G_LOCK (cache);
+    g_free (cache_directory);
+    cache_directory = g_strdup (directory);
+    cache_flags     = flags | GHWP_CACHE_INDEX;
+    G_UNLOCK (cache);
+}
+
+/**
+ * ghwp_cache_get_directory:
+ *
+ * Returns: (transfer full): the cache directory, or %NULL if the cache is
+ * disabled
+ */
+gchar *ghwp_cache_get_directory (void)
+{
+    gchar *directory;
+
+    G_LOCK (cache);
+    directory = g_strdup (cache_directory);
+    G_UNLOCK (cache);
+
+    return directory;
+}
+
+/* 캐시가 꺼져 있거나 파일 정보를 얻을 수 없으면 NULL 을 반환한다. */
+gchar *_ghwp_cache_get_path (const gchar *filename,
+                             GBytes      *file_header,
+                             GBytes      *doc_info)
+{
+    GChecksum *checksum;
+    GStatBuf   st;
+    gint64     size;
+    gint64     mtime;
+    gchar     *directory;
+    gchar     *name;
+    gchar     *path;
+
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    directory = ghwp_cache_get_directory ();
+    if (directory == NULL)
+        return NULL;
+
+    if (g_stat (filename, &st) != 0) {
+        g_free (directory);
+        return NULL;
+    }
+
+    size  = (gint64) st.st_size;
+    mtime = (gint64) st.st_mtime;
+
+    checksum = g_checksum_new (G_CHECKSUM_SHA1);
+    g_checksum_update (checksum, (const guchar *) &size,  sizeof (size));
+    g_checksum_update (checksum, (const guchar *) &mtime, sizeof (mtime));
+    if (file_header)
+        g_checksum_update (checksum, g_bytes_get_data (file_header, NULL),
+                           g_bytes_get_size (file_header));
+    if (doc_info)
+        g_checksum_update (checksum, g_bytes_get_data (doc_info, NULL),
+                           g_bytes_get_size (doc_info));
+
+    name = g_strconcat (g_checksum_get_string (checksum), ".ghwpcache", NULL);
+    path = g_build_filename (directory, name, NULL);
+
+    g_checksum_free (checksum);
+    g_free (name);
+    g_free (directory);
+
+    return path;
+}
+
+/* 캐시 파일 안의 조각을 가리키는 GBytes, 범위를 벗어나면 NULL */
+static GBytes *cache_slice (GBytes  *bytes,
+                            guint64  offset,
+                            guint64  count,
+                            gsize    elem_size)
+{
+    gsize total = g_bytes_get_size (bytes);
+
+    if (offset % 8 != 0 || offset > total)
+        return NULL;
+    if (count > (total - offset) / elem_size)
+        return NULL;
+
+    return g_bytes_new_from_bytes (bytes, (gsize) offset,
+                                   (gsize) (count * elem_size));
+}
+
+/**
+ * _ghwp_cache_load:
+ * @path: a path returned by _ghwp_cache_get_path()
+ * @n_sections: the number of sections in the file
+ * @record_index: (out): an array of #GHWPRecordIndex
+ * @section_data: (out): an array of #GBytes, some of which may be %NULL
+ *
+ * Maps the cache file at @path. Nothing is copied; the returned objects
+ * point into the mapping.
+ *
+ * Returns: %TRUE if a valid cache entry was found
+ */
+gboolean _ghwp_cache_load (const gchar *path,
+                           guint        n_sections,
+                           GPtrArray  **record_index,
+                           GPtrArray  **section_data)
+{
+    GMappedFile            *mapped;
+    GBytes                 *bytes;
+    const guint8           *data;
+    gsize                   size;
+    const GHWPCacheHeader  *header;
+    const GHWPCacheSection *sections;
+    GPtrArray              *indexes;
+    GPtrArray              *datas;
+    guint                   i;
+
+    g_return_val_if_fail (path != NULL, FALSE);
+
+    mapped = g_mapped_file_new (path, FALSE, NULL);
+    if (mapped == NULL)
+        return FALSE;
+
+    bytes = g_mapped_file_get_bytes (mapped);
+    g_mapped_file_unref (mapped);
+    data  = g_bytes_get_data (bytes, &size);
+
+    header = (const GHWPCacheHeader *) data;
+
+    if (size < sizeof (GHWPCacheHeader) ||
+        memcmp (header->magic, GHWP_CACHE_MAGIC, sizeof (header->magic)) != 0 ||
+        header->byte_order != GHWP_CACHE_BYTE_ORDER ||
+        header->version    != GHWP_CACHE_VERSION    ||
+        header->n_sections != n_sections            ||
+        (size - sizeof (GHWPCacheHeader)) / sizeof (GHWPCacheSection) < n_sections) {
+        g_bytes_unref (bytes);
+        return FALSE;
+    }
+
+    sections = (const GHWPCacheSection *) (data + sizeof (GHWPCacheHeader));
+    indexes  = g_ptr_array_new_full (n_sections, _g_object_unref0_);
+    datas    = g_ptr_array_new_full (n_sections, _g_bytes_unref0_);
+
+    for (i = 0; i < n_sections; i++) {
+        const GHWPCacheSection *sec = &sections[i];
+        GHWPRecordIndex *index = NULL;
+        GBytes *records;
+        GBytes *paragraphs;
+        GBytes *page_marks;
+        GBytes *section = NULL;
+
+        records    = cache_slice (bytes, sec->records_offset,
+                                  sec->n_records, sizeof (GHWPRecord));
+        paragraphs = cache_slice (bytes, sec->paragraphs_offset,
+                                  sec->n_paragraphs, sizeof (guint32));
+        page_marks = cache_slice (bytes, sec->page_marks_offset,
+                                  sec->n_page_marks, sizeof (GHWPPageMark));
+
+        if (records && paragraphs && page_marks && sec->section_size <= G_MAXSIZE)
+            index = _ghwp_record_index_new_from_tables (records, paragraphs,
+                                                        page_marks,
+                                                        (gsize) sec->section_size,
+                                                        sec->page_h_size,
+                                                        sec->page_v_size);
+        /* 저장한 섹션은 인덱스를 만든 섹션과 크기가 같아야 한다 */
+        if (sec->data_size > 0 && sec->data_size == sec->section_size)
+            section = cache_slice (bytes, sec->data_offset, sec->data_size, 1);
+
+        if (records)    g_bytes_unref (records);
+        if (paragraphs) g_bytes_unref (paragraphs);
+        if (page_marks) g_bytes_unref (page_marks);
+
+        if (index == NULL || (sec->data_size > 0 && section == NULL)) {
+            if (index)   g_object_unref (index);
+            if (section) g_bytes_unref (section);
+            g_ptr_array_unref (indexes);
+            g_ptr_array_unref (datas);
+            g_bytes_unref (bytes);
+            return FALSE;
+        }
+
+        g_ptr_array_add (indexes, index);
+        g_ptr_array_add (datas, section);
+    }
+
+    g_bytes_unref (bytes);
+
+    *record_index = indexes;
+    *section_data = datas;
+    return TRUE;
+}
+
+static gboolean cache_write (GOutputStream *stream,
+                             GBytes        *bytes,
+                             GError       **error)
+{
+    static const guint8 zeros[8] = { 0, };
+    gsize size = bytes ? g_bytes_get_size (bytes) : 0;
+
+    if (size > 0 &&
+        !g_output_stream_write_all (stream, g_bytes_get_data (bytes, NULL),
+                                    size, NULL, NULL, error))
+        return FALSE;
+
+    return g_output_stream_write_all (stream, zeros,
+                                      GHWP_CACHE_ALIGN (size) - size,
+                                      NULL, NULL, error);
+}
+
+/**
+ * _ghwp_cache_store:
+ * @path: a path returned by _ghwp_cache_get_path()
+ * @record_index: an array of #GHWPRecordIndex, one per section
+ * @section_data: (allow-none): an array of #GBytes, one per section
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Writes a cache file. The file is replaced atomically so that readers
+ * never map a partially written file. Section data is written only if
+ * %GHWP_CACHE_SECTIONS was given to ghwp_cache_set_directory().
+ *
+ * Returns: %TRUE on success
+ */
+gboolean _ghwp_cache_store (const gchar *path,
+                            GPtrArray   *record_index,
+                            GPtrArray   *section_data,
+                            GError     **error)
+{
+    GHWPCacheHeader    header;
+    GHWPCacheSection  *sections;
+    GFile             *file;
+    gchar             *directory;
+    GFileOutputStream *stream;
+    GOutputStream     *out;
+    gboolean           store_data;
+    gboolean           is_success = TRUE;
+    guint64            pos;
+    guint              i;
+
+    g_return_val_if_fail (path != NULL, FALSE);
+    g_return_val_if_fail (record_index != NULL, FALSE);
+
+    for (i = 0; i < record_index->len; i++)
+        g_return_val_if_fail (GHWP_IS_RECORD_INDEX (g_ptr_array_index (record_index, i)),
+                              FALSE);
+
+    G_LOCK (cache);
+    store_data = (cache_flags & GHWP_CACHE_SECTIONS) && section_data;
+    G_UNLOCK (cache);
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, GHWP_CACHE_MAGIC, sizeof (header.magic));
+    header.byte_order = GHWP_CACHE_BYTE_ORDER;
+    header.version    = GHWP_CACHE_VERSION;
+    header.n_sections = record_index->len;
+
+    /* 각 섹션의 위치를 먼저 정한다 */
+    sections = g_new0 (GHWPCacheSection, record_index->len);
+    pos = sizeof (GHWPCacheHeader) +
+          sizeof (GHWPCacheSection) * record_index->len;
+
+    for (i = 0; i < record_index->len; i++) {
+        GHWPRecordIndex *index = g_ptr_array_index (record_index, i);
+        GBytes *data = store_data && i < section_data->len ?
+                       g_ptr_array_index (section_data, i) : NULL;
+
+        sections[i].n_records    = index->priv->n_records;
+        sections[i].n_paragraphs = index->priv->n_paragraphs;
+        sections[i].n_page_marks = index->priv->n_page_marks;
+        sections[i].section_size = index->priv->section_size;
+        sections[i].page_h_size  = index->priv->page_h_size;
+        sections[i].page_v_size  = index->priv->page_v_size;
+
+        sections[i].records_offset = pos;
+        pos += GHWP_CACHE_ALIGN (g_bytes_get_size (index->priv->records));
+        sections[i].paragraphs_offset = pos;
+        pos += GHWP_CACHE_ALIGN (g_bytes_get_size (index->priv->paragraphs));
+        sections[i].page_marks_offset = pos;
+        pos += GHWP_CACHE_ALIGN (g_bytes_get_size (index->priv->page_marks));
+
+        if (data) {
+            sections[i].data_offset = pos;
+            sections[i].data_size   = g_bytes_get_size (data);
+            pos += GHWP_CACHE_ALIGN (g_bytes_get_size (data));
+        }
+    }
+
+    directory = g_path_get_dirname (path);
+    g_mkdir_with_parents (directory, 0700);
+    g_free (directory);
+
+    /* 임시 파일에 쓴 다음 바꿔치기 한다 */
+    file   = g_file_new_for_path (path);
+    stream = g_file_replace (file, NULL, FALSE,
+                             G_FILE_CREATE_PRIVATE |
+                             G_FILE_CREATE_REPLACE_DESTINATION,
+                             NULL, error);
+    g_object_unref (file);
+
+    if (stream == NULL) {
+        g_free (sections);
+        return FALSE;
+    }
+
+    out = G_OUTPUT_STREAM (stream);
+
+    is_success = g_output_stream_write_all (out, &header, sizeof (header),
+                                            NULL, NULL, error) &&
+                 g_output_stream_write_all (out, sections,
+                                            sizeof (GHWPCacheSection) * record_index->len,
+                                            NULL, NULL, error);
+
+    for (i = 0; is_success && i < record_index->len; i++) {
+        GHWPRecordIndex *index = g_ptr_array_index (record_index, i);
+
+        is_success = cache_write (out, index->priv->records,    error) &&
+                     cache_write (out, index->priv->paragraphs, error) &&
+                     cache_write (out, index->priv->page_marks, error);
+
+        if (is_success && sections[i].data_size > 0)
+            is_success = cache_write (out, g_ptr_array_index (section_data, i),
+                                      error);
+    }
+
+    /* 실패하면 닫기 전에 취소해서 원래 파일을 남겨 둔다 */
+    if (is_success) {
+        is_success = g_output_stream_close (out, NULL, error);
+    } else {
+        GCancellable *cancellable = g_cancellable_new ();
+        g_cancellable_cancel (cancellable);
+        g_output_stream_close (out, cancellable, NULL);
+        g_object_unref (cancellable);
+    }
+
+    g_object_unref (stream);
+    g_free (sections);
+
+    return is_success;
+}
+
+/**
+ * _ghwp_cache_get_search_index_path:
+ * @path: (allow-none): a path returned by _ghwp_cache_get_path()
+ *
+ * Returns: where to keep the search index of the same file, or %NULL if
+ * %GHWP_CACHE_SEARCH_INDEX was not given to ghwp_cache_set_directory()
+ */
+gchar *_ghwp_cache_get_search_index_path (const gchar *path)
+{
+    gboolean enabled;
+    gsize    len;
+    gchar   *base;
+    gchar   *search_path;
+
+    if (path == NULL)
+        return NULL;
+
+    G_LOCK (cache);
+    enabled = (cache_flags & GHWP_CACHE_SEARCH_INDEX) != 0;
+    G_UNLOCK (cache);
+
+    if (!enabled)
+        return NULL;
+
+    /* 캐시 파일과 이름은 같고 확장자만 다르다 */
+    len = strlen (path);
+    if (g_str_has_suffix (path, ".ghwpcache"))
+        len -= strlen (".ghwpcache");
+
+    base        = g_strndup (path, len);
+    search_path = g_strconcat (base, ".ghwpsearch", NULL);
+    g_free (base);
+
+    return search_path;
+}
@@ -0,0 +1,43 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-cache.h
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GHWP_CACHE_H__
+#define __GHWP_CACHE_H__
+
+#include <glib-object.h>
+
+#include "ghwp.h"
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    GHWP_CACHE_INDEX        = 1 << 0, /* 섹션별 레코드 인덱스 */
+    GHWP_CACHE_SECTIONS     = 1 << 1, /* 압축을 푼 섹션 데이터 */
+    GHWP_CACHE_SEARCH_INDEX = 1 << 2  /* 전문 검색 색인 */
+} GHWPCacheFlags;
+
+void      ghwp_cache_set_directory (const gchar    *directory,
+                                    GHWPCacheFlags  flags);
+gchar    *ghwp_cache_get_directory (void);
+
+G_END_DECLS
+
+#endif /* __GHWP_CACHE_H__ */
@@ -18,6 +18,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "ghwp.h"
+#include "ghwp-private.h"
 #include "ghwp-context-v3.h"
 
 G_DEFINE_TYPE (GHWPContextV3, ghwp_context_v3, G_TYPE_OBJECT);
@@ -109,19 +111,17 @@ gboolean ghwp_context_v3_read (GHWPContextV3 *context, void *buffer, gsize count
     return TRUE;
 }
 
-gboolean ghwp_context_v3_skip (GHWPContextV3 *context, guint16 count)
+gboolean ghwp_context_v3_skip (GHWPContextV3 *context, guint32 count)
 {
     g_return_val_if_fail (context != NULL, FALSE);
 
     gboolean is_success = FALSE;
-    guint8  *buf        = g_malloc (count);
 
-    is_success = g_input_stream_read_all (context->stream, buf, (gsize) count,
-                                          &context->bytes_read,
+    is_success = _ghwp_input_stream_skip (context->stream, (gsize) count,
+                                          context->scratch,
+                                          sizeof (context->scratch),
                                           NULL, NULL);
-    g_free (buf);
-
-    if ((is_success == FALSE) || (context->bytes_read != (gsize) count))
+    if (is_success == FALSE)
     {
         g_warning ("%s:%d:skip size mismatch\n", __FILE__, __LINE__);
         g_input_stream_close (context->stream, NULL, NULL);
@@ -46,6 +46,7 @@ struct _GHWPContextV3
 	GObject       parent_instance;
     GInputStream *stream;
     gsize         bytes_read;
+    guint8        scratch[4096]; /* 건너뛰기용 */
 };
 
 GType          ghwp_context_v3_get_type    (void) G_GNUC_CONST;
@@ -60,7 +61,7 @@ gboolean       ghwp_context_v3_read        (GHWPContextV3 *context,
                                             void          *buffer,
                                             gsize          count);
 gboolean       ghwp_context_v3_skip        (GHWPContextV3 *context,
-                                            guint16        count);
+                                            guint32        count);
 G_END_DECLS
 
 #endif /* _GHWP_CONTEXT_V3_H_ */
\ No newline at end of file
@@ -30,9 +30,19 @@
 #include "config.h"
 #include "ghwp-document.h"
 #include "ghwp-parse.h"
+#include "ghwp-private.h"
 
 G_DEFINE_TYPE (GHWPDocument, ghwp_document, G_TYPE_OBJECT);
 
+struct _GHWPDocumentPrivate {
+    gboolean  body_pending;  /* 본문을 아직 읽지 않았다 */
+    GError   *body_error;    /* 본문을 읽다가 난 에러 */
+    guint    *section_pages; /* 섹션마다 첫 페이지 번호, 끝에 전체 페이지 수 */
+    gdouble  *section_sizes; /* 섹션마다 용지의 너비와 높이 (픽셀) */
+    guint     n_sections;
+    GHWPSearchIndex *search_index; /* 처음 찾을 때 만든다 */
+};
+
 /* private function */
 static void   ghwp_document_finalize               (GObject      *obj);
 
@@ -69,26 +79,466 @@ GHWPDocument *ghwp_document_new_from_uri (const gchar *uri, GError **error)
 
 GHWPDocument *
 ghwp_document_new_from_filename (const gchar *filename, GError **error)
+{
+    return ghwp_document_new_from_filename_full (filename, GHWP_OPEN_NONE,
+                                                 NULL, error);
+}
+
+/**
+ * ghwp_document_new_from_uri_full:
+ * @uri: uri of the file to load
+ * @flags: #GHWPOpenFlags to load the document with
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Like ghwp_document_new_from_uri(), but loads the document according
+ * to @flags. See ghwp_document_new_from_filename_full().
+ *
+ * Return value: A newly created #GHWPDocument, or %NULL
+ **/
+GHWPDocument *ghwp_document_new_from_uri_full (const gchar   *uri,
+                                               GHWPOpenFlags  flags,
+                                               GCancellable  *cancellable,
+                                               GError       **error)
+{
+    g_return_val_if_fail (uri != NULL, NULL);
+
+    gchar        *filename = g_filename_from_uri (uri, NULL, error);
+    GHWPDocument *document;
+
+    if (filename == NULL)
+        return NULL;
+
+    document = ghwp_document_new_from_filename_full (filename, flags,
+                                                     cancellable, error);
+    _g_free0 (filename);
+    return document;
+}
+
+/**
+ * ghwp_document_new_from_filename_full:
+ * @filename: path of the file to load
+ * @flags: #GHWPOpenFlags to load the document with
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Like ghwp_document_new_from_filename(), but loads the document
+ * according to @flags. With %GHWP_OPEN_PARALLEL, the sections of a
+ * multi-section document are decompressed and parsed concurrently, so
+ * the time to open it depends on the largest section rather than on all
+ * of them. The result is the same as loading them one by one.
+ *
+ * @cancellable stays with the document: cancelling it also stops the
+ * body text from being parsed later and pictures from being decoded.
+ *
+ * Return value: A newly created #GHWPDocument, or %NULL
+ **/
+GHWPDocument *
+ghwp_document_new_from_filename_full (const gchar   *filename,
+                                      GHWPOpenFlags  flags,
+                                      GCancellable  *cancellable,
+                                      GError       **error)
 {
     g_return_val_if_fail (filename != NULL, NULL);
 
-    GHWPFile *file = ghwp_file_new_from_filename (filename, error);
+    GHWPFile *file = ghwp_file_new_from_filename_full (filename, flags,
+                                                       cancellable, error);
 
     if (file == NULL) {
         return NULL;
     }
 
-    if (*error) return NULL;
-
     return ghwp_file_get_document (file, error);
 }
 
+typedef struct
+{
+    GFile         *file;
+    GHWPOpenFlags  flags;
+} GHWPDocumentOpenData;
+
+static void ghwp_document_open_data_free (gpointer data)
+{
+    GHWPDocumentOpenData *open_data = data;
+
+    g_object_unref (open_data->file);
+    g_free (open_data);
+}
+
+/* 아직 만들지 않은 섹션을 모두 만든다 */
+static gboolean ghwp_document_build_sections (GHWPDocument *doc,
+                                              GError      **error)
+{
+    guint index;
+
+    if (doc->priv->section_pages == NULL ||
+        GHWP_FILE_GET_CLASS (doc->file)->build_section == NULL)
+        return TRUE;
+
+    for (index = 0; index < doc->sections->len; index++) {
+        if (!GHWP_FILE_GET_CLASS (doc->file)->build_section (doc->file, doc,
+                                                             index, error))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void ghwp_document_open_thread (GTask        *task,
+                                       gpointer      source_object,
+                                       gpointer      task_data,
+                                       GCancellable *cancellable)
+{
+    GHWPDocumentOpenData *open_data = task_data;
+    GHWPDocument         *doc = NULL;
+    GHWPFile             *file;
+    GError               *error = NULL;
+
+    file = _ghwp_file_new_from_gfile (open_data->file, open_data->flags,
+                                      cancellable, &error);
+    if (file) {
+        doc = ghwp_file_get_document (file, &error);
+        if (doc == NULL)
+            g_object_unref (file);
+    }
+
+    /* 페이지를 얻을 때 부른 스레드가 막히지 않도록 본문 전체를 여기서
+     * 만든다 */
+    if (doc && error == NULL && ghwp_document_load_body (doc, &error))
+        ghwp_document_build_sections (doc, &error);
+
+    if (error) {
+        _g_object_unref0 (doc);
+        g_task_return_error (task, error);
+        return;
+    }
+
+    if (doc == NULL) {
+        g_task_return_new_error (task, GHWP_ERROR, GHWP_ERROR_INVALID,
+                                 "invalid hwp file");
+        return;
+    }
+
+    g_task_return_pointer (task, doc, g_object_unref);
+}
+
+/**
+ * ghwp_document_new_from_file_async:
+ * @file: a #GFile to load
+ * @flags: #GHWPOpenFlags to load the document with
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the document is loaded
+ * @user_data: data to pass to @callback
+ *
+ * Loads the document in @file in a worker thread: the file is opened,
+ * its document info is parsed and all of its pages are built, so that
+ * ghwp_document_get_page() does not parse anything later. @callback is
+ * called in the thread-default main context of the caller; call
+ * ghwp_document_new_from_file_finish() from it to get the result.
+ *
+ * A local file is mapped; any other #GFile is read into memory with
+ * g_file_read().
+ */
+void ghwp_document_new_from_file_async (GFile              *file,
+                                        GHWPOpenFlags       flags,
+                                        GCancellable       *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer            user_data)
+{
+    GHWPDocumentOpenData *open_data;
+    GTask                *task;
+
+    g_return_if_fail (G_IS_FILE (file));
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, ghwp_document_new_from_file_async);
+
+    open_data = g_new0 (GHWPDocumentOpenData, 1);
+    open_data->file  = g_object_ref (file);
+    open_data->flags = flags;
+    g_task_set_task_data (task, open_data, ghwp_document_open_data_free);
+
+    g_task_run_in_thread (task, ghwp_document_open_thread);
+    g_object_unref (task);
+}
+
+/**
+ * ghwp_document_new_from_file_finish:
+ * @result: the #GAsyncResult passed to the callback
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Finishes an operation started with ghwp_document_new_from_file_async().
+ *
+ * Returns: (transfer full): A newly created #GHWPDocument, or %NULL on
+ *     error
+ */
+GHWPDocument *ghwp_document_new_from_file_finish (GAsyncResult *result,
+                                                  GError      **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* 본문을 나중에 읽을 문서로 표시한다 */
+void _ghwp_document_set_body_pending (GHWPDocument *doc)
+{
+    g_return_if_fail (GHWP_IS_DOCUMENT (doc));
+    doc->priv->body_pending = TRUE;
+}
+
+/* 처음 찾을 때 만든 검색 인덱스 */
+GHWPSearchIndex *_ghwp_document_get_search_index (GHWPDocument *doc)
+{
+    g_return_val_if_fail (GHWP_IS_DOCUMENT (doc), NULL);
+    return doc->priv->search_index;
+}
+
+/* 검색 인덱스의 참조는 문서가 가져간다 */
+void _ghwp_document_set_search_index (GHWPDocument    *doc,
+                                      GHWPSearchIndex *index)
+{
+    g_return_if_fail (GHWP_IS_DOCUMENT (doc));
+
+    _g_object_unref0 (doc->priv->search_index);
+    doc->priv->search_index = index;
+}
+
+/* 섹션마다의 페이지 수로 페이지 표를 만든다. doc->pages 는 전체 페이지
+ * 수만큼 NULL 로 채워 두고, 섹션을 만들 때 그 자리를 채운다.
+ * sizes 는 섹션마다 용지의 너비와 높이이며 NULL 일 수 있다. */
+void _ghwp_document_set_page_table (GHWPDocument  *doc,
+                                    const guint   *n_pages,
+                                    const gdouble *sizes,
+                                    guint          n_sections)
+{
+    GHWPDocumentPrivate *priv;
+    guint                i;
+
+    g_return_if_fail (GHWP_IS_DOCUMENT (doc));
+
+    priv = doc->priv;
+    g_free (priv->section_pages);
+    priv->section_pages = g_new (guint, n_sections + 1);
+    priv->n_sections    = n_sections;
+
+    priv->section_pages[0] = 0;
+    for (i = 0; i < n_sections; i++)
+        priv->section_pages[i + 1] = priv->section_pages[i] + n_pages[i];
+
+    g_array_set_size (doc->pages, priv->section_pages[n_sections]);
+
+    _g_free0 (priv->section_sizes);
+    if (sizes) {
+        priv->section_sizes = g_new (gdouble, 2 * n_sections);
+        memcpy (priv->section_sizes, sizes, sizeof (gdouble) * 2 * n_sections);
+    }
+}
+
+/* 만든 섹션의 페이지를 doc->pages 에서 그 섹션의 자리에 넣는다. 페이지
+ * 표를 만들 때와 페이지 수가 다르면 자리를 늘리거나 줄이고 뒤 섹션들의
+ * 첫 페이지 번호를 옮긴다. 페이지의 참조는 문서가 가져간다. */
+void _ghwp_document_set_section_pages (GHWPDocument  *doc,
+                                       guint          index,
+                                       GHWPPage     **pages,
+                                       guint          n_pages)
+{
+    GHWPDocumentPrivate *priv;
+    guint                first;
+    guint                old_n_pages;
+    guint                i;
+
+    g_return_if_fail (GHWP_IS_DOCUMENT (doc));
+    g_return_if_fail (index < doc->priv->n_sections);
+
+    priv        = doc->priv;
+    first       = priv->section_pages[index];
+    old_n_pages = priv->section_pages[index + 1] - first;
+
+    for (i = first; i < first + old_n_pages; i++)
+        _g_object_unref0 (g_array_index (doc->pages, GHWPPage *, i));
+
+    if (n_pages != old_n_pages) {
+        g_warning ("%s:%d: page table mismatch in section %u (%u != %u)\n",
+                   __FILE__, __LINE__, index, n_pages, old_n_pages);
+
+        g_array_remove_range (doc->pages, first, old_n_pages);
+        g_array_insert_vals (doc->pages, first, pages, n_pages);
+
+        for (i = index + 1; i <= priv->n_sections; i++)
+            priv->section_pages[i] = priv->section_pages[i] - old_n_pages + n_pages;
+        return;
+    }
+
+    for (i = 0; i < n_pages; i++)
+        g_array_index (doc->pages, GHWPPage *, first + i) = pages[i];
+}
+
+/* n_page 를 포함하는 섹션을 찾는다 */
+static guint ghwp_document_find_section (GHWPDocument *doc, guint n_page)
+{
+    const guint *first = doc->priv->section_pages;
+    guint        lo = 0;
+    guint        hi = doc->priv->n_sections;
+
+    while (hi - lo > 1) {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (first[mid] <= n_page)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * ghwp_document_set_progress_callback:
+ * @doc: a #GHWPDocument
+ * @func: (allow-none): a #GHWPProgressFunc, or %NULL to remove it
+ * @user_data: data to pass to @func
+ * @notify: (allow-none): function to free @user_data, or %NULL
+ *
+ * Sets a callback that reports the progress of ghwp_document_load_body().
+ * The body is loaded on first use, so set the callback before asking
+ * for the pages.
+ */
+void ghwp_document_set_progress_callback (GHWPDocument    *doc,
+                                          GHWPProgressFunc func,
+                                          gpointer         user_data,
+                                          GDestroyNotify   notify)
+{
+    g_return_if_fail (GHWP_IS_DOCUMENT (doc));
+
+    ghwp_file_set_progress_callback (doc->file, func, user_data, notify);
+}
+
+/**
+ * ghwp_document_load_body:
+ * @doc: a #GHWPDocument
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Parses the body text of @doc if it has not been parsed yet. Opening a
+ * document reads only its header, document info and summary, so the
+ * metadata getters are cheap; the body is parsed by the first call to
+ * this function, ghwp_document_get_n_pages() or ghwp_document_get_page().
+ * Calling it again returns the result of the first call.
+ *
+ * Returns: %FALSE if the body could not be parsed, %TRUE otherwise
+ */
+gboolean ghwp_document_load_body (GHWPDocument *doc, GError **error)
+{
+    GHWPDocumentPrivate *priv;
+
+    g_return_val_if_fail (GHWP_IS_DOCUMENT (doc), FALSE);
+
+    priv = doc->priv;
+
+    if (priv->body_pending) {
+        priv->body_pending = FALSE;
+        if (GHWP_FILE_GET_CLASS (doc->file)->parse_body) {
+            _ghwp_file_begin_progress (doc->file);
+            GHWP_FILE_GET_CLASS (doc->file)->parse_body (doc->file, doc,
+                                                         &priv->body_error);
+            _ghwp_file_end_progress (doc->file);
+        }
+    }
+
+    if (priv->body_error) {
+        g_propagate_error (error, g_error_copy (priv->body_error));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void ghwp_document_ensure_body (GHWPDocument *doc)
+{
+    GError *error = NULL;
+
+    if (G_LIKELY (!doc->priv->body_pending))
+        return;
+
+    if (!ghwp_document_load_body (doc, &error)) {
+        g_warning ("%s:%d: %s\n", __FILE__, __LINE__, error->message);
+        g_error_free (error);
+    }
+}
+
+/**
+ * ghwp_document_get_n_pages:
+ * @doc: a #GHWPDocument
+ *
+ * Returns the number of pages without building any page. For HWP v5
+ * documents the count comes from the record headers of the body text
+ * (the line segments that start a page), so no paragraph, table or
+ * picture is parsed.
+ *
+ * Returns: the number of pages in @doc
+ */
 guint ghwp_document_get_n_pages (GHWPDocument *doc)
 {
     g_return_val_if_fail (doc != NULL, 0U);
+    ghwp_document_ensure_body (doc);
     return doc->pages->len;
 }
 
+/**
+ * ghwp_document_get_page_sizes:
+ * @doc: a #GHWPDocument
+ * @widths: (allow-none): array of ghwp_document_get_n_pages() elements
+ *     to store the page widths in, or %NULL
+ * @heights: (allow-none): array of ghwp_document_get_n_pages() elements
+ *     to store the page heights in, or %NULL
+ *
+ * Stores the size of every page in pixels, the same values as
+ * ghwp_page_get_size(). For HWP v5 documents the sizes are read from the
+ * page definition of each section without building the pages.
+ */
+void ghwp_document_get_page_sizes (GHWPDocument *doc,
+                                   gdouble      *widths,
+                                   gdouble      *heights)
+{
+    GHWPDocumentPrivate *priv;
+    guint                i;
+
+    g_return_if_fail (GHWP_IS_DOCUMENT (doc));
+    ghwp_document_ensure_body (doc);
+
+    priv = doc->priv;
+
+    if (priv->section_sizes && priv->section_pages) {
+        guint index;
+
+        for (index = 0; index < priv->n_sections; index++) {
+            for (i = priv->section_pages[index];
+                 i < priv->section_pages[index + 1]; i++) {
+                if (widths)
+                    widths[i]  = priv->section_sizes[index * 2];
+                if (heights)
+                    heights[i] = priv->section_sizes[index * 2 + 1];
+            }
+        }
+        return;
+    }
+
+    /* 용지 표가 없으면 페이지를 만들어서 묻는다 */
+    for (i = 0; i < doc->pages->len; i++) {
+        GHWPPage *page = ghwp_document_get_page (doc, (gint) i);
+        gdouble   width = 0.0, height = 0.0;
+
+        if (page) {
+            ghwp_page_get_size (page, &width, &height);
+            g_object_unref (page);
+        }
+        if (widths)
+            widths[i]  = width;
+        if (heights)
+            heights[i] = height;
+    }
+}
+
 /**
  * ghwp_document_get_page:
  * @doc: a #GHWPDocument
@@ -102,7 +552,29 @@ guint ghwp_document_get_n_pages (GHWPDocument *doc)
 GHWPPage *ghwp_document_get_page (GHWPDocument *doc, gint n_page)
 {
     g_return_val_if_fail (doc != NULL, NULL);
+    ghwp_document_ensure_body (doc);
+    g_return_val_if_fail (n_page >= 0 && (guint) n_page < doc->pages->len,
+                          NULL);
+
     GHWPPage *page = g_array_index (doc->pages, GHWPPage *, (guint) n_page);
+
+    /* 그 페이지가 있는 섹션만 만든다 */
+    if (page == NULL && doc->priv->section_pages &&
+        GHWP_FILE_GET_CLASS (doc->file)->build_section) {
+        GError *error = NULL;
+        guint   index = ghwp_document_find_section (doc, (guint) n_page);
+
+        if (!GHWP_FILE_GET_CLASS (doc->file)->build_section (doc->file, doc,
+                                                             index, &error)) {
+            g_warning ("%s:%d: %s\n", __FILE__, __LINE__, error->message);
+            g_error_free (error);
+        }
+
+        /* 페이지 표와 달라 섹션의 페이지 수가 줄었을 수 있다 */
+        if ((guint) n_page < doc->pages->len)
+            page = g_array_index (doc->pages, GHWPPage *, (guint) n_page);
+    }
+
     return _g_object_ref0 (page);
 }
 
@@ -121,11 +593,14 @@ GHWPDocument *ghwp_document_new (void)
 static void ghwp_document_class_init (GHWPDocumentClass *klass)
 {
     GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    g_type_class_add_private (klass, sizeof (GHWPDocumentPrivate));
     object_class->finalize     = ghwp_document_finalize;
 }
 
 static void ghwp_document_init (GHWPDocument *doc)
 {
+    doc->priv = G_TYPE_INSTANCE_GET_PRIVATE (doc, GHWP_TYPE_DOCUMENT,
+                                                  GHWPDocumentPrivate);
     doc->paragraphs = g_array_new (TRUE, TRUE, sizeof (GHWPParagraph *));
     doc->pages      = g_array_new (TRUE, TRUE, sizeof (GHWPPage *));
     doc->sections   = g_array_new (TRUE, TRUE, sizeof (GHWPSection *));
@@ -140,6 +615,10 @@ static void ghwp_document_finalize (GObject *obj)
     _g_array_free0 (doc->pages);
     _g_array_free0 (doc->sections);
     _g_object_unref0 (doc->summary_info);
+    _g_error_free0 (doc->priv->body_error);
+    _g_free0 (doc->priv->section_pages);
+    _g_free0 (doc->priv->section_sizes);
+    _g_object_unref0 (doc->priv->search_index);
     G_OBJECT_CLASS (ghwp_document_parent_class)->finalize (obj);
 }
 
@@ -318,6 +797,19 @@ ghwp_document_get_hwp_version (GHWPDocument *document,
                                extra_version);
 }
 
+static const GHWPField document_property_fields[] = {
+    GHWP_FIELD (GHWPDocumentProperty, n_sections,         GHWP_U16),
+    GHWP_FIELD (GHWPDocumentProperty, start_page_num,     GHWP_U16),
+    GHWP_FIELD (GHWPDocumentProperty, start_footnote_num, GHWP_U16),
+    GHWP_FIELD (GHWPDocumentProperty, start_endnote_num,  GHWP_U16),
+    GHWP_FIELD (GHWPDocumentProperty, start_picture_num,  GHWP_U16),
+    GHWP_FIELD (GHWPDocumentProperty, start_table_num,    GHWP_U16),
+    GHWP_FIELD (GHWPDocumentProperty, start_math_num,     GHWP_U16),
+    GHWP_FIELD (GHWPDocumentProperty, list_id,            GHWP_U32),
+    GHWP_FIELD (GHWPDocumentProperty, paragraph_id,       GHWP_U32),
+    GHWP_FIELD (GHWPDocumentProperty, char_unit_pos,      GHWP_U32),
+};
+
 void ghwp_parse_document_property (GHWPDocument *doc,
                                    GHWPContext  *ctx)
 {
@@ -328,16 +820,8 @@ void ghwp_parse_document_property (GHWPDocument *doc,
 
     prop = &doc->info_v5.prop;
 
-    context_read_uint16 (ctx, &prop->n_sections);
-    context_read_uint16 (ctx, &prop->start_page_num);
-    context_read_uint16 (ctx, &prop->start_footnote_num);
-    context_read_uint16 (ctx, &prop->start_endnote_num);
-    context_read_uint16 (ctx, &prop->start_picture_num);
-    context_read_uint16 (ctx, &prop->start_table_num);
-    context_read_uint16 (ctx, &prop->start_math_num);
-    context_read_uint32 (ctx, &prop->list_id);
-    context_read_uint32 (ctx, &prop->paragraph_id);
-    context_read_uint32 (ctx, &prop->char_unit_pos);
+    context_decode (ctx, document_property_fields,
+                    G_N_ELEMENTS (document_property_fields), prop);
 }
 
 void ghwp_parse_document_id_mapping (GHWPDocument *doc,
@@ -459,12 +943,29 @@ void ghwp_parse_document_font_face (GHWPDocument *doc,
     }
 }
 
+static const GHWPField char_shape_fields[] = {
+    GHWP_FIELD_N (GHWPCharShape, face_id,  CHAR_SHAPE_LANG_NUM, GHWP_U16),
+    GHWP_FIELD_N (GHWPCharShape, width,    CHAR_SHAPE_LANG_NUM, GHWP_U8),
+    GHWP_FIELD_N (GHWPCharShape, space,    CHAR_SHAPE_LANG_NUM, GHWP_U8),
+    GHWP_FIELD_N (GHWPCharShape, rel_size, CHAR_SHAPE_LANG_NUM, GHWP_U8),
+    GHWP_FIELD_N (GHWPCharShape, rel_pos,  CHAR_SHAPE_LANG_NUM, GHWP_U8),
+    GHWP_FIELD (GHWPCharShape, def_size,     GHWP_I32),
+    GHWP_FIELD (GHWPCharShape, attr,         GHWP_U32),
+    GHWP_FIELD (GHWPCharShape, shadow_size1, GHWP_I8),
+    GHWP_FIELD (GHWPCharShape, shadow_size2, GHWP_I8),
+    GHWP_FIELD (GHWPCharShape, char_color,   GHWP_U32),
+    GHWP_FIELD (GHWPCharShape, line_color,   GHWP_U32),
+    GHWP_FIELD (GHWPCharShape, shade_color,  GHWP_U32),
+    GHWP_FIELD (GHWPCharShape, shadow_color, GHWP_U32),
+    GHWP_FIELD_SINCE (GHWPCharShape, border_fill_id, GHWP_U16, 5, 0, 2, 1),
+    GHWP_FIELD_SINCE (GHWPCharShape, midline_color,  GHWP_U32, 5, 0, 3, 0),
+};
+
 void ghwp_parse_document_char_shape (GHWPDocument *doc,
                                      GHWPContext  *ctx,
                                      gint          idx)
 {
     GHWPCharShape *char_shape;
-    gint i;
 
     g_return_if_fail (GHWP_IS_DOCUMENT (doc));
     g_return_if_fail (GHWP_IS_CONTEXT (ctx));
@@ -472,32 +973,29 @@ void ghwp_parse_document_char_shape (GHWPDocument *doc,
 
     char_shape = &doc->info_v5.char_shapes[idx];
 
-    for(i = 0; i < CHAR_SHAPE_LANG_NUM; i++)
-        context_read_uint16 (ctx, &char_shape->face_id[i]);
-    for(i = 0; i < CHAR_SHAPE_LANG_NUM; i++)
-        context_read_uint8 (ctx, &char_shape->width[i]);
-    for(i = 0; i < CHAR_SHAPE_LANG_NUM; i++)
-        context_read_uint8 (ctx, &char_shape->space[i]);
-    for(i = 0; i < CHAR_SHAPE_LANG_NUM; i++)
-        context_read_uint8 (ctx, &char_shape->rel_size[i]);
-    for(i = 0; i < CHAR_SHAPE_LANG_NUM; i++)
-        context_read_uint8 (ctx, &char_shape->rel_pos[i]);
-
-    context_read_int32 (ctx, &char_shape->def_size);
-    context_read_uint32 (ctx, &char_shape->attr);
-    context_read_int8 (ctx, &char_shape->shadow_size1);
-    context_read_int8 (ctx, &char_shape->shadow_size2);
-    context_read_hwp_color (ctx, &char_shape->char_color);
-    context_read_hwp_color (ctx, &char_shape->line_color);
-    context_read_hwp_color (ctx, &char_shape->shade_color);
-    context_read_hwp_color (ctx, &char_shape->shadow_color);
-
-    if (context_check_version (ctx, 5, 0, 2, 1))
-        context_read_uint16 (ctx, &char_shape->border_fill_id);
-    if (context_check_version (ctx, 5, 0, 3, 0))
-        context_read_hwp_color (ctx, &char_shape->midline_color);
+    context_decode (ctx, char_shape_fields,
+                    G_N_ELEMENTS (char_shape_fields), char_shape);
 }
 
+static const GHWPField para_shape_fields[] = {
+    GHWP_FIELD (GHWPParaShape, attr1,     GHWP_U32),
+    GHWP_FIELD (GHWPParaShape, l_margin,  GHWP_I32),
+    GHWP_FIELD (GHWPParaShape, r_margin,  GHWP_I32),
+    GHWP_FIELD (GHWPParaShape, indent,    GHWP_I32),
+    GHWP_FIELD (GHWPParaShape, u_spacing, GHWP_I32),
+    GHWP_FIELD (GHWPParaShape, d_spacing, GHWP_I32),
+    GHWP_FIELD_BEFORE (GHWPParaShape, l_spacing_old, GHWP_I32, 5, 0, 1, 7),
+    GHWP_FIELD (GHWPParaShape, tab_def_id,       GHWP_U16),
+    GHWP_FIELD (GHWPParaShape, numbering_id,     GHWP_U16),
+    GHWP_FIELD (GHWPParaShape, border_fill_id,   GHWP_U16),
+    GHWP_FIELD (GHWPParaShape, border_l_spacing, GHWP_I16),
+    GHWP_FIELD (GHWPParaShape, border_r_spacing, GHWP_I16),
+    GHWP_FIELD (GHWPParaShape, border_u_spacing, GHWP_I16),
+    GHWP_FIELD (GHWPParaShape, border_d_spacing, GHWP_I16),
+    GHWP_FIELD_SINCE  (GHWPParaShape, attr2, GHWP_U32, 5, 0, 1, 7),
+    GHWP_FIELD_BEFORE (GHWPParaShape, attr3, GHWP_U32, 5, 0, 2, 5),
+};
+
 void ghwp_parse_document_para_shape (GHWPDocument *doc,
                                      GHWPContext  *ctx,
                                      gint          idx)
@@ -510,29 +1008,6 @@ void ghwp_parse_document_para_shape (GHWPDocument *doc,
 
     para_shape = &doc->info_v5.para_shapes[idx];
 
-    context_read_uint32 (ctx, &para_shape->attr1);
-    context_read_int32 (ctx, &para_shape->l_margin);
-    context_read_int32 (ctx, &para_shape->r_margin);
-    context_read_int32 (ctx, &para_shape->indent);
-    context_read_int32 (ctx, &para_shape->u_spacing);
-    context_read_int32 (ctx, &para_shape->d_spacing);
-
-    if (!context_check_version (ctx, 5, 0, 1, 7))
-        context_read_int32 (ctx, &para_shape->l_spacing_old);
-
-    context_read_uint16 (ctx, &para_shape->tab_def_id);
-    context_read_uint16 (ctx, &para_shape->numbering_id);
-    context_read_uint16 (ctx, &para_shape->border_fill_id);
-
-    context_read_int16 (ctx, &para_shape->border_l_spacing);
-    context_read_int16 (ctx, &para_shape->border_r_spacing);
-    context_read_int16 (ctx, &para_shape->border_u_spacing);
-    context_read_int16 (ctx, &para_shape->border_d_spacing);
-
-    if (context_check_version (ctx, 5, 0, 1, 7))
-        context_read_uint32 (ctx, &para_shape->attr2);
-
-    if (!context_check_version (ctx, 5, 0, 2, 5)) {
-        context_read_uint32 (ctx, &para_shape->attr3);
-    }
+    context_decode (ctx, para_shape_fields,
+                    G_N_ELEMENTS (para_shape_fields), para_shape);
 }
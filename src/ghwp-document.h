@@ -267,7 +267,33 @@ GHWPDocument *ghwp_document_new_from_uri       (const gchar  *uri,
                                                 GError      **error);
 GHWPDocument *ghwp_document_new_from_filename  (const gchar  *filename,
                                                 GError      **error);
+GHWPDocument *ghwp_document_new_from_uri_full  (const gchar   *uri,
+                                                GHWPOpenFlags  flags,
+                                                GCancellable  *cancellable,
+                                                GError       **error);
+GHWPDocument *ghwp_document_new_from_filename_full
+                                               (const gchar   *filename,
+                                                GHWPOpenFlags  flags,
+                                                GCancellable  *cancellable,
+                                                GError       **error);
+void      ghwp_document_new_from_file_async    (GFile              *file,
+                                                GHWPOpenFlags       flags,
+                                                GCancellable       *cancellable,
+                                                GAsyncReadyCallback callback,
+                                                gpointer            user_data);
+GHWPDocument *ghwp_document_new_from_file_finish
+                                               (GAsyncResult  *result,
+                                                GError       **error);
+void      ghwp_document_set_progress_callback  (GHWPDocument    *doc,
+                                                GHWPProgressFunc func,
+                                                gpointer         user_data,
+                                                GDestroyNotify   notify);
+gboolean  ghwp_document_load_body              (GHWPDocument *doc,
+                                                GError      **error);
 guint     ghwp_document_get_n_pages            (GHWPDocument *doc);
+void      ghwp_document_get_page_sizes         (GHWPDocument *doc,
+                                                gdouble      *widths,
+                                                gdouble      *heights);
 GHWPPage *ghwp_document_get_page               (GHWPDocument *doc, gint n_page);
 /* meta data */
 gchar    *ghwp_document_get_title              (GHWPDocument *document);
@@ -300,6 +326,7 @@ void      ghwp_parse_document_char_shape       (GHWPDocument *doc,
 void      ghwp_parse_document_para_shape       (GHWPDocument *doc,
                                                 GHWPContext  *ctx,
                                                 gint          idx);
+
 G_END_DECLS
 
 #endif /* __GHWP_DOCUMENT_H__ */
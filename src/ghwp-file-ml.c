@@ -46,6 +46,16 @@ GHWPFileML *ghwp_file_ml_new_from_filename (const gchar *filename,
     return file;
 }
 
+GHWPFileML *ghwp_file_ml_new_from_bytes (GBytes *bytes, GError **error)
+{
+    g_return_val_if_fail (bytes != NULL, NULL);
+
+    GHWPFileML *file = g_object_new (GHWP_TYPE_FILE_ML, NULL);
+    file->priv->bytes = g_bytes_ref (bytes);
+
+    return file;
+}
+
 gchar *ghwp_file_ml_get_hwp_version_string (GHWPFile *file)
 {
     return NULL;
@@ -120,7 +130,8 @@ static void _ghwp_file_ml_parse_node(GHWPDocument    *doc,
                 /* 높이 계산 */
                 static gdouble y   = 0.0;
                 static guint   len = 0;
-                len = g_utf8_strlen (paragraph->ghwp_text->text, -1);
+                /* 문단이 끝났으므로 모은 텍스트를 확정한다 */
+                len = g_utf8_strlen (ghwp_text_get_text (paragraph->ghwp_text), -1);
                 y += 18.0 * ceil (len / 33.0);
 
                 if (y > 842.0 - 80.0) {
@@ -152,12 +163,20 @@ static void _ghwp_file_ml_parse (GHWPDocument *doc, GError **error)
 {
     g_return_if_fail (doc != NULL);
 
-    gchar *uri = GHWP_FILE_ML (doc->file)->priv->uri;
-    
+    GHWPFileMLPrivate *priv = GHWP_FILE_ML (doc->file)->priv;
+    const gchar       *uri  = priv->uri ? priv->uri : "(memory)";
+
     xmlTextReaderPtr reader;
     int              ret;
 
-    reader = xmlNewTextReaderFilename (uri);
+    if (priv->bytes) {
+        gsize         size;
+        gconstpointer data = g_bytes_get_data (priv->bytes, &size);
+
+        reader = xmlReaderForMemory (data, (int) size, NULL, NULL, 0);
+    } else {
+        reader = xmlNewTextReaderFilename (uri);
+    }
 
     if (reader != NULL) {
         while ((ret = xmlTextReaderRead(reader)) == 1) {
@@ -194,6 +213,8 @@ static void ghwp_file_ml_finalize (GObject *object)
 {
     GHWPFileML *file = GHWP_FILE_ML(object);
     g_free (file->priv->uri);
+    if (file->priv->bytes)
+        g_bytes_unref (file->priv->bytes);
     G_OBJECT_CLASS (ghwp_file_ml_parent_class)->finalize (object);
 }
 
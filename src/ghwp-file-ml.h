@@ -50,7 +50,8 @@ struct _GHWPFileML
 
 struct _GHWPFileMLPrivate
 {
-    gchar *uri;
+    gchar  *uri;
+    GBytes *bytes;  /* 메모리에서 열었으면 파일 전체, uri 는 NULL */
 };
 
 GType         ghwp_file_ml_get_type               (void) G_GNUC_CONST;
@@ -58,6 +59,8 @@ GHWPFileML   *ghwp_file_ml_new_from_uri           (const gchar *uri,
                                                    GError     **error);
 GHWPFileML   *ghwp_file_ml_new_from_filename      (const gchar *filename,
                                                    GError     **error);
+GHWPFileML   *ghwp_file_ml_new_from_bytes         (GBytes      *bytes,
+                                                   GError     **error);
 gchar        *ghwp_file_ml_get_hwp_version_string (GHWPFile    *file);
 void          ghwp_file_ml_get_hwp_version        (GHWPFile    *file,
                                                    guint8      *major_version,
@@ -54,6 +54,23 @@ GHWPFileV3 *ghwp_file_v3_new_from_filename (const gchar *filename,
     return hwpv3file;
 }
 
+/**
+ * ghwp_file_v3_new_from_bytes:
+ * @bytes: a #GBytes holding the whole file
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Opens a v3 file that is already in memory, without copying it.
+ *
+ * Returns: A newly created #GHWPFileV3
+ */
+GHWPFileV3 *ghwp_file_v3_new_from_bytes (GBytes *bytes, GError **error)
+{
+    g_return_val_if_fail (bytes != NULL, NULL);
+    GHWPFileV3 *hwpv3file = g_object_new (GHWP_TYPE_FILE_V3, NULL);
+    hwpv3file->priv->stream = g_memory_input_stream_new_from_bytes (bytes);
+    return hwpv3file;
+}
+
 gchar *ghwp_file_v3_get_hwp_version_string (GHWPFile *file)
 {
     g_return_val_if_fail (GHWP_IS_FILE_V3 (file), NULL);
@@ -70,6 +70,8 @@ GHWPFileV3   *ghwp_file_v3_new_from_uri           (const gchar *uri,
                                                    GError     **error);
 GHWPFileV3   *ghwp_file_v3_new_from_filename      (const gchar *filename,
                                                    GError     **error);
+GHWPFileV3   *ghwp_file_v3_new_from_bytes         (GBytes      *bytes,
+                                                   GError     **error);
 gchar        *ghwp_file_v3_get_hwp_version_string (GHWPFile    *file);
 void          ghwp_file_v3_get_hwp_version        (GHWPFile    *file,
                                                    guint8      *major_version,
@@ -34,7 +34,6 @@
 #include <gsf/gsf-input-impl.h>
 #include <gsf/gsf-input-memory.h>
 #include <gsf/gsf-msole-utils.h>
-#include <gsf/gsf-input-stdio.h>
 #include <gsf/gsf-infile-impl.h>
 #include <gsf/gsf-doc-meta-data.h>
 #include <gsf/gsf-meta-names.h>
@@ -44,7 +43,11 @@
 #include "ghwp-document.h"
 #include "ghwp-file-v5.h"
 #include "ghwp-parse.h"
+#include "ghwp-cache.h"
+#include "ghwp-private.h"
+#include "ghwp-text-arena.h"
 #include "config.h"
+#include <glib/gi18n-lib.h>
 
 G_DEFINE_TYPE (GHWPFileV5, ghwp_file_v5, GHWP_TYPE_FILE);
 
@@ -74,6 +77,8 @@ static void _ghwp_file_v5_parse_doc_info (GHWPDocument *doc, GError **error)
     context->version[1] = file->minor_version;
     context->version[2] = file->micro_version;
     context->version[3] = file->extra_version;
+    ghwp_context_set_cancellable (context,
+                                  _ghwp_file_get_cancellable (doc->file));
 
     while (ghwp_context_pull (context, error)) {
         switch (context->tag_id) {
@@ -128,228 +133,619 @@ static void prepare_picture (GHWPPicture *pic, GHWPDocument *doc)
                                  item->bindata_id - 1);
 }
 
-/* TODO fsm parser, nautilus에서 파일 속성만 보는 경우가 있으므로 속도 문제
- * 때문에 get_n_pages 로 옮겨갈 필요가 있다. */
-static void _ghwp_file_v5_parse_body_text (GHWPDocument *doc, GError **error)
+static GBytes *_ghwp_inflate              (const guint8 *raw,
+                                           gsize         raw_size,
+                                           GError      **error);
+static GBytes *_ghwp_file_v5_read_section (GHWPFileV5   *file,
+                                           guint         index,
+                                           GError      **error);
+
+/* 섹션 하나의 레코드를 읽어 GHWPSection 을 만든다. 문서에서는 다 읽은
+ * DocInfo 와 BinData 스트림 목록만 읽으므로 여러 스레드에서 섹션마다
+ * 따로 불러도 된다. */
+static GHWPSection *_ghwp_file_v5_build_section (GHWPDocument    *doc,
+                                                 GBytes          *section_data,
+                                                 GHWPRecordIndex *record_index)
 {
-    g_return_if_fail (doc != NULL);
-    guint32 ctrl_id = 0;
-    guint   index;
     GHWPFileV5    *file = GHWP_FILE_V5(doc->file);
-    GHWPPage      *page = NULL;
+    GHWPContext   *context;
     GHWPSection   *section;
     GHWPParagraph *paragraph = NULL;
+    GHWPTable     *table = NULL;
+    GHWPTableCell *cell = NULL;
+    GHWPGSO       *gso = NULL;
+    GHWPListHeader lhdr;
+    GHWPTextArena *arena;
+    GCancellable  *cancellable = _ghwp_file_get_cancellable (doc->file);
+    guint32        ctrl_id = 0;
+    gsize          text_size = 0;
+    guint          i;
+
+    context = ghwp_context_new_from_bytes (section_data);
+    context->version[0] = file->major_version;
+    context->version[1] = file->minor_version;
+    context->version[2] = file->micro_version;
+    context->version[3] = file->extra_version;
 
-    for (index = 0; index < file->section_streams->len; index++) {
-        GInputStream  *section_stream;
-        GHWPContext   *context;
-        GHWPTable     *table = NULL;
-        GHWPTableCell *cell = NULL;
-        GHWPGSO       *gso = NULL;
-        GHWPListHeader lhdr;
-
-        section_stream = g_array_index (file->section_streams,
-                                        GInputStream *,
-                                        index);
-        section_stream = _g_object_ref0 (section_stream);
-
-        context = ghwp_context_new (section_stream);
-        context->version[0] = file->major_version;
-        context->version[1] = file->minor_version;
-        context->version[2] = file->micro_version;
-        context->version[3] = file->extra_version;
-
-        section = ghwp_section_new ();
-        section->document = doc;
-        g_array_append_val (doc->sections, section);
-
-        while (ghwp_context_pull(context, error)) {
-            GHWPContextStatus *curr_status = &context->status[context->level];
-
-            dbg ("%*stag = %u [%s] (size: %u)\n", context->level*3, "",
-                 context->tag_id, _ghwp_get_tag_name (context->tag_id),
-                 context->data_len);
-
-            switch (context->tag_id) {
-            case GHWP_TAG_PARA_HEADER:
-                paragraph = ghwp_paragraph_new ();
-                ghwp_parse_paragraph_header (paragraph, context);
-
-                if (context->level == 0) {
-                    ghwp_section_add_paragraph (section, paragraph);
-                } else if (curr_status->s == STATE_TABLE) {
-                    cell  = curr_status->p;
-                    ghwp_table_cell_add_paragraph (cell, paragraph);
-                }
-
-                /* do not update current state, but next state is set */
-                context->status[context->level + 1].p = paragraph;
-                context->status[context->level + 1].s = STATE_PARAGRAPH;
-                break;
+    section = ghwp_section_new ();
+    section->document = doc;
 
-            case GHWP_TAG_PARA_TEXT:
-            case GHWP_TAG_PARA_CHAR_SHAPE:
-            case GHWP_TAG_PARA_LINE_SEG:
-            case GHWP_TAG_PARA_RANGE_TAG:
-                if (curr_status->s != STATE_PARAGRAPH)
-                    g_warning ("invalid paragraph data");
+    /* 섹션의 문단 텍스트를 한 블록에 담을 수 있도록 크기를 미리 센다 */
+    for (i = 0; i < ghwp_record_index_get_n_records (record_index); i++) {
+        const GHWPRecord *record = ghwp_record_index_get_record (record_index, i);
 
-                paragraph = curr_status->p;
+        if (record->tag_id == GHWP_TAG_PARA_TEXT)
+            text_size += (record->data_len + 3) & ~3U;
+    }
+    arena = _ghwp_text_arena_new (text_size);
 
-                if (context->tag_id == GHWP_TAG_PARA_TEXT)
-                    ghwp_parse_paragraph_text (paragraph, context);
-                else if (context->tag_id == GHWP_TAG_PARA_CHAR_SHAPE)
-                    ghwp_parse_paragraph_char_shape (paragraph, context);
-                else if (context->tag_id == GHWP_TAG_PARA_LINE_SEG)
-                    ghwp_parse_paragraph_line_seg (paragraph, context);
-                else if (context->tag_id == GHWP_TAG_PARA_RANGE_TAG)
-                    ghwp_parse_paragraph_range_tag (paragraph, context);
+    for (i = 0; i < ghwp_record_index_get_n_records (record_index); i++) {
+        GHWPContextStatus *curr_status;
 
-                break;
+        /* 취소되었으면 그만 둔다. 호출하는 쪽에서 버린다. */
+        if ((i & 0x3ff) == 0 && g_cancellable_is_cancelled (cancellable))
+            break;
 
-            case GHWP_TAG_CTRL_HEADER:
-                context_read_uint32 (context, &ctrl_id);
-
-                dbg ("%*s ctrl: "CTRL_ID_FMT"\n", context->level * 3, "",
-                     CTRL_ID_PRINT (ctrl_id));
-
-                switch (ctrl_id) {
-                case CTRL_ID_TABLE:
-                    table = ghwp_table_new ();
-                    table->obj.ctrl_id = ctrl_id;
-                    ghwp_parse_common_object (&table->obj, context);
-
-                    paragraph = curr_status->p;
-                    ghwp_paragraph_set_table (paragraph, table);
-
-                    curr_status->s = STATE_CTRL_TABLE;
-                    curr_status->p = table;
-                    break;
-                case CTRL_ID_SEC_DEF:
-                    ghwp_parse_section_def (section, context);
-                    break;
-                case CTRL_ID_COL_DEF:
-                    ghwp_parse_column_def (section, context);
-                    break;
-                case CTRL_ID_GSO:  /* GenShapeObject? */
-                    gso = ghwp_gso_new ();
-                    ghwp_parse_common_object (&gso->object, context);
-                    curr_status->s = STATE_GSO;
-                    curr_status->p = gso;
-                    break;
-                default:
-                    curr_status->s = STATE_NORMAL;
-                    break;
-                }
-                break;
+        ghwp_context_set_record (context,
+            ghwp_record_index_get_record (record_index, i));
+        curr_status = &context->status[context->level];
 
-            case GHWP_TAG_TABLE:
-                table = context->status[context->level - 1].p;
-                ghwp_parse_table_attr (table, context);
+        dbg ("%*stag = %u [%s] (size: %u)\n", context->level*3, "",
+             context->tag_id, _ghwp_get_tag_name (context->tag_id),
+             context->data_len);
 
-                curr_status->s = STATE_TABLE;
-                break;
+        switch (context->tag_id) {
+        case GHWP_TAG_PARA_HEADER:
+            paragraph = ghwp_paragraph_new ();
+            ghwp_parse_paragraph_header (paragraph, context);
+
+            if (context->level == 0) {
+                ghwp_section_add_paragraph (section, paragraph);
+            } else if (curr_status->s == STATE_TABLE) {
+                cell  = curr_status->p;
+                ghwp_table_cell_add_paragraph (cell, paragraph);
+            }
 
-            case GHWP_TAG_LIST_HEADER:
-                ghwp_parse_list_header (&lhdr, context);
-                /* TODO ctrl_id 에 따른 객체를 생성한다 */
-                switch (curr_status->s) {
-                /* table에 cell을 추가한다 */
-                case STATE_CTRL_TABLE:
-                    /* caption */
-                    break;
-                case STATE_TABLE:
-                    table = context->status[context->level - 1].p;
-                    cell  = ghwp_table_cell_new ();
-                    ghwp_parse_table_cell_attr (cell, context);
-                    memcpy (&cell->header, &lhdr, sizeof (lhdr));
-                    /* FIXME 테이블 내에서 페이지가 나누어지는 경우 처리 */
-                    ghwp_table_add_cell (table, cell);
-                    curr_status->p = cell;
-                    break;
-                default:
-                    break;
-                }
-                break;
+            /* do not update current state, but next state is set */
+            context->status[context->level + 1].p = paragraph;
+            context->status[context->level + 1].s = STATE_PARAGRAPH;
+            break;
 
-            case GHWP_TAG_PAGE_DEF:
-                ghwp_parse_page_def (section, context);
-                break;
+        case GHWP_TAG_PARA_TEXT:
+        case GHWP_TAG_PARA_CHAR_SHAPE:
+        case GHWP_TAG_PARA_LINE_SEG:
+        case GHWP_TAG_PARA_RANGE_TAG:
+            if (curr_status->s != STATE_PARAGRAPH)
+                g_warning ("invalid paragraph data");
 
-            case GHWP_TAG_SHAPE_COMPONENT:
-                if (context->status[context->level - 1].s == STATE_GSO) {
-                    guint32 real_id;
+            paragraph = curr_status->p;
 
-                    /* 개체 요소: GenShapeObject일 경우 id가 두 번 기록 됨) */
-                    context_read_uint32 (context, &real_id);
+            if (context->tag_id == GHWP_TAG_PARA_TEXT)
+                ghwp_parse_paragraph_text (paragraph, context, arena);
+            else if (context->tag_id == GHWP_TAG_PARA_CHAR_SHAPE)
+                ghwp_parse_paragraph_char_shape (paragraph, context);
+            else if (context->tag_id == GHWP_TAG_PARA_LINE_SEG)
+                ghwp_parse_paragraph_line_seg (paragraph, context);
+            else if (context->tag_id == GHWP_TAG_PARA_RANGE_TAG)
+                ghwp_parse_paragraph_range_tag (paragraph, context);
 
-                    dbg ("%*s component: "CTRL_ID_FMT"\n", context->level * 3, "",
-                         CTRL_ID_PRINT (real_id));
+            break;
 
-                    gso = context->status[context->level - 1].p;
-                    ghwp_parse_shape_component (&gso->component, context);
-                }
-                break;
+        case GHWP_TAG_CTRL_HEADER:
+            context_read_uint32 (context, &ctrl_id);
+
+            dbg ("%*s ctrl: "CTRL_ID_FMT"\n", context->level * 3, "",
+                 CTRL_ID_PRINT (ctrl_id));
 
-            case GHWP_TAG_SHAPE_COMPONENT_PICTURE:
-                if (context->status[context->level - 2].s == STATE_GSO) {
-                    gso = context->status[context->level - 2].p;
-                } else {
-                    g_warning ("picture without gso");
-                    break;
-                }
-
-                gso->u.picture = ghwp_picture_new ();
-                ghwp_parse_picture (gso->u.picture, context);
-                ghwp_picture_set_gso (gso->u.picture, gso);
-                prepare_picture (gso->u.picture, doc);
-                ghwp_paragraph_set_picture (paragraph, gso->u.picture);
+            switch (ctrl_id) {
+            case CTRL_ID_TABLE:
+                table = ghwp_table_new ();
+                table->obj.ctrl_id = ctrl_id;
+                ghwp_parse_common_object (&table->obj, context);
+
+                paragraph = curr_status->p;
+                ghwp_paragraph_set_table (paragraph, table);
+
+                curr_status->s = STATE_CTRL_TABLE;
+                curr_status->p = table;
+                break;
+            case CTRL_ID_SEC_DEF:
+                ghwp_parse_section_def (section, context);
+                break;
+            case CTRL_ID_COL_DEF:
+                ghwp_parse_column_def (section, context);
+                break;
+            case CTRL_ID_GSO:  /* GenShapeObject? */
+                gso = ghwp_gso_new ();
+                ghwp_parse_common_object (&gso->object, context);
+                curr_status->s = STATE_GSO;
+                curr_status->p = gso;
                 break;
+            default:
+                curr_status->s = STATE_NORMAL;
+                break;
+            }
+            break;
+
+        case GHWP_TAG_TABLE:
+            table = context->status[context->level - 1].p;
+            ghwp_parse_table_attr (table, context);
 
+            curr_status->s = STATE_TABLE;
+            break;
+
+        case GHWP_TAG_LIST_HEADER:
+            ghwp_parse_list_header (&lhdr, context);
+            /* TODO ctrl_id 에 따른 객체를 생성한다 */
+            switch (curr_status->s) {
+            /* table에 cell을 추가한다 */
+            case STATE_CTRL_TABLE:
+                /* caption */
+                break;
+            case STATE_TABLE:
+                table = context->status[context->level - 1].p;
+                cell  = ghwp_table_cell_new ();
+                ghwp_parse_table_cell_attr (cell, context);
+                memcpy (&cell->header, &lhdr, sizeof (lhdr));
+                /* FIXME 테이블 내에서 페이지가 나누어지는 경우 처리 */
+                ghwp_table_add_cell (table, cell);
+                curr_status->p = cell;
+                break;
             default:
                 break;
-            } /* switch */
-        } /* while */
+            }
+            break;
+
+        case GHWP_TAG_PAGE_DEF:
+            ghwp_parse_page_def (section, context);
+            break;
+
+        case GHWP_TAG_SHAPE_COMPONENT:
+            if (context->status[context->level - 1].s == STATE_GSO) {
+                guint32 real_id;
 
-        _g_object_unref0 (context);
-        _g_object_unref0 (section_stream);
+                /* 개체 요소: GenShapeObject일 경우 id가 두 번 기록 됨) */
+                context_read_uint32 (context, &real_id);
+
+                dbg ("%*s component: "CTRL_ID_FMT"\n", context->level * 3, "",
+                     CTRL_ID_PRINT (real_id));
+
+                gso = context->status[context->level - 1].p;
+                ghwp_parse_shape_component (&gso->component, context);
+            }
+            break;
+
+        case GHWP_TAG_SHAPE_COMPONENT_PICTURE:
+            if (context->status[context->level - 2].s == STATE_GSO) {
+                gso = context->status[context->level - 2].p;
+            } else {
+                g_warning ("picture without gso");
+                break;
+            }
+
+            gso->u.picture = ghwp_picture_new ();
+            ghwp_parse_picture (gso->u.picture, context);
+            ghwp_picture_set_gso (gso->u.picture, gso);
+            prepare_picture (gso->u.picture, doc);
+            ghwp_paragraph_set_picture (paragraph, gso->u.picture);
+            break;
+
+        default:
+            break;
+        } /* switch */
     } /* for */
 
-    /* create pages */
-    for (index = 0; index < doc->sections->len; index++) {
-        section = g_array_index (doc->sections, GHWPSection *, index);
-        page    = NULL;
+    /* 텍스트들이 arena 의 참조를 가진다 */
+    _ghwp_text_arena_unref (arena);
+    _g_object_unref0 (context);
+    return section;
+}
 
-        gint i, n;
-        for (i = 0; i < section->paragraphs->len; i++) {
-            paragraph = g_array_index (section->paragraphs, GHWPParagraph *, i);
+typedef struct
+{
+    GHWPDocument    *doc;           /* NULL 이면 객체는 만들지 않는다 */
+    GBytes          *raw;           /* 압축된 섹션, 이미 풀었으면 NULL */
+    GBytes          *section_data;
+    GHWPRecordIndex *record_index;
+    GHWPSection     *section;
+    GCancellable    *cancellable;
+    GError          *error;
+} GHWPSectionJob;
+
+static void _ghwp_section_job (gpointer data, gpointer user_data)
+{
+    GHWPSectionJob *job = data;
 
-            for (n = 0; n < paragraph->header.n_line_segs; n++) {
-                GHWPLineSeg *line;
+    if (g_cancellable_set_error_if_cancelled (job->cancellable, &job->error))
+        return;
 
-                line = g_array_index (paragraph->line_segs, GHWPLineSeg *, n);
-                if (line->v_pos != 0)
-                    continue;
+    if (job->section_data == NULL) {
+        gsize         size;
+        const guint8 *raw = g_bytes_get_data (job->raw, &size);
 
-                if (n != 0) {  /* 문단 내에서 페이지가 바뀌는 경우 */
-                    if (page == NULL)
-                        g_warning("invalid line seg?");
+        job->section_data = _ghwp_inflate (raw, size, &job->error);
+        if (job->section_data == NULL)
+            return;
+    }
 
-                    GHWPParagraph *link_paragraph = ghwp_paragraph_new ();
-                    ghwp_paragraph_add_link (paragraph, link_paragraph, n);
+    /* 캐시에서 읽은 인덱스가 섹션과 맞지 않으면 다시 훑는다 */
+    if (job->record_index &&
+        job->record_index->priv->section_size !=
+        g_bytes_get_size (job->section_data))
+        _g_object_unref0 (job->record_index);
+
+    if (job->record_index == NULL) {
+        job->record_index = ghwp_record_index_new (job->section_data,
+                                                   &job->error);
+        if (job->record_index == NULL)
+            return;
+    }
 
-                    ghwp_page_add_paragraph (page, paragraph);
-                    paragraph = link_paragraph;
-                }
+    if (job->doc) {
+        job->section = _ghwp_file_v5_build_section (job->doc,
+                                                    job->section_data,
+                                                    job->record_index);
+        if (g_cancellable_set_error_if_cancelled (job->cancellable,
+                                                  &job->error))
+            _g_object_unref0 (job->section);
+    }
+}
+
+/* 만든 섹션의 압축을 푼 바이트는 버린다. 다시 필요하면 다시 푼다.
+ * 캐시 파일을 매핑한 바이트는 메모리를 차지하지 않으므로 남긴다. */
+static void _ghwp_file_v5_drop_section_data (GHWPFileV5 *file, guint index)
+{
+    GPtrArray *section_data = file->priv->section_data;
+
+    if (section_data == NULL || index >= section_data->len)
+        return;
+    if (file->priv->section_cached && file->priv->section_cached[index])
+        return;
 
-                page = ghwp_page_new ();
-                ghwp_page_set_section (page, section);
+    _g_bytes_unref0_ (g_ptr_array_index (section_data, index));
+    g_ptr_array_index (section_data, index) = NULL;
+}
+
+/* 섹션마다 압축 풀기, 레코드 인덱스, (build_model 이면) 객체 만들기를
+ * 스레드 풀에서 한다. libgsf 는 스레드에 안전하지 않으므로 스트림은 이
+ * 스레드에서 읽는다. 결과는 섹션 순서대로 모으므로 차례로 만든 것과
+ * 같다. 이미 되어 있는 섹션은 건너뛴다. */
+static gboolean _ghwp_file_v5_build_sections_parallel (GHWPDocument *doc,
+                                                       gboolean      build_model,
+                                                       GError      **error)
+{
+    GHWPFileV5     *file = GHWP_FILE_V5(doc->file);
+    GHWPSectionJob *jobs;
+    GThreadPool    *pool;
+    guint           n_sections = ghwp_file_v5_get_n_sections (file);
+    guint           i;
+    gboolean        ret = TRUE;
+
+    if (file->priv->section_data == NULL)
+        file->priv->section_data = g_ptr_array_new_with_free_func (
+                                       _g_bytes_unref0_);
+    if (file->priv->section_data->len < n_sections)
+        g_ptr_array_set_size (file->priv->section_data, n_sections);
+    if (file->priv->record_index == NULL)
+        file->priv->record_index = g_ptr_array_new_with_free_func (
+                                       _g_object_unref0_);
+    if (file->priv->record_index->len < n_sections)
+        g_ptr_array_set_size (file->priv->record_index, n_sections);
+
+    jobs = g_new0 (GHWPSectionJob, n_sections);
+    pool = g_thread_pool_new (_ghwp_section_job, NULL,
+                              (gint) MIN (g_get_num_processors (), n_sections),
+                              FALSE, NULL);
+
+    for (i = 0; i < n_sections; i++) {
+        GHWPSectionJob *job = &jobs[i];
+
+        if (build_model) {
+            if (g_array_index (doc->sections, GHWPSection *, i))
+                continue;
+        } else if (g_ptr_array_index (file->priv->record_index, i)) {
+            continue;
+        }
 
-                g_array_append_val (doc->pages, page);
+        if (g_cancellable_set_error_if_cancelled (
+                _ghwp_file_get_cancellable (doc->file), error)) {
+            ret = FALSE;
+            break;
+        }
+
+        job->doc          = build_model ? doc : NULL;
+        job->cancellable  = _ghwp_file_get_cancellable (doc->file);
+        job->section_data = g_ptr_array_index (file->priv->section_data, i);
+        job->record_index = g_ptr_array_index (file->priv->record_index, i);
+
+        if (job->section_data) {
+            g_bytes_ref (job->section_data);
+        } else if (file->is_compress) {
+            job->raw = _ghwp_file_v5_read_section (file, i, error);
+            if (job->raw == NULL) {
+                ret = FALSE;
+                break;
+            }
+        } else {
+            job->section_data = _ghwp_file_v5_read_section (file, i, error);
+            if (job->section_data == NULL) {
+                ret = FALSE;
+                break;
             }
+        }
+
+        if (job->record_index)
+            g_object_ref (job->record_index);
+
+        if (pool)
+            g_thread_pool_push (pool, job, NULL);
+        else
+            _ghwp_section_job (job, NULL);
+    }
+
+    /* 모든 작업이 끝날 때까지 기다린다 */
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i = 0; i < n_sections; i++) {
+        GHWPSectionJob *job = &jobs[i];
+
+        if (job->section_data == NULL && job->raw == NULL)
+            continue;  /* 건너뛴 섹션 */
+
+        if (job->error) {
+            if (ret)
+                g_propagate_error (error, job->error);
+            else
+                g_error_free (job->error);
+            ret = FALSE;
+        }
+
+        if (ret) {
+            /* 인덱스만 만들었으면 섹션을 만들 때까지 바이트를 둔다 */
+            if (job->section == NULL &&
+                g_ptr_array_index (file->priv->section_data, i) == NULL)
+                g_ptr_array_index (file->priv->section_data, i) =
+                    g_bytes_ref (job->section_data);
+            if (g_ptr_array_index (file->priv->record_index, i) !=
+                job->record_index) {
+                _g_object_unref0 (g_ptr_array_index (file->priv->record_index, i));
+                g_ptr_array_index (file->priv->record_index, i) =
+                    g_object_ref (job->record_index);
+            }
+
+            if (job->section) {
+                g_array_index (doc->sections, GHWPSection *, i) = job->section;
+                job->section = NULL;
+                _ghwp_file_v5_drop_section_data (file, i);
+            }
+        }
+
+        _g_object_unref0 (job->section);
+        _g_object_unref0 (job->record_index);
+        if (job->section_data)
+            g_bytes_unref (job->section_data);
+        if (job->raw)
+            g_bytes_unref (job->raw);
+    }
+
+    g_free (jobs);
+    return ret;
+}
+
+/* 섹션의 문단을 페이지로 나누어 doc->pages 에서 그 섹션의 자리에 넣는다.
+ * 페이지 표를 만들 때 센 레코드 인덱스의 페이지 표시를 그대로 따르므로
+ * 두 쪽의 페이지 수가 같다. */
+static void _ghwp_file_v5_make_pages (GHWPDocument *doc, guint index)
+{
+    GHWPFileV5      *file    = GHWP_FILE_V5 (doc->file);
+    GHWPSection     *section = g_array_index (doc->sections, GHWPSection *, index);
+    GHWPRecordIndex *record_index;
+    GPtrArray       *pages;
+    GHWPPage        *page = NULL;
+    GHWPParagraph   *paragraph;
+    guint            n_marks;
+    guint            mark = 0;
+    guint            i;
+
+    record_index = g_ptr_array_index (file->priv->record_index, index);
+    n_marks      = ghwp_record_index_get_n_page_marks (record_index);
+    pages        = g_ptr_array_new ();
+
+    for (i = 0; i < section->paragraphs->len; i++) {
+        paragraph = g_array_index (section->paragraphs, GHWPParagraph *, i);
+
+        for (; mark < n_marks; mark++) {
+            const GHWPPageMark *page_mark;
+
+            page_mark = ghwp_record_index_get_page_mark (record_index, mark);
+            if (page_mark->paragraph != i)
+                break;
+
+            if (page_mark->line_seg != 0) {  /* 문단 내에서 페이지가 바뀌는 경우 */
+                GHWPParagraph *link_paragraph;
+
+                if (page == NULL)
+                    g_warning("invalid line seg?");
+
+                link_paragraph = ghwp_paragraph_new ();
+                ghwp_paragraph_add_link (paragraph, link_paragraph,
+                                         page_mark->line_seg);
+
+                if (page)
+                    ghwp_page_add_paragraph (page, paragraph);
+                paragraph = link_paragraph;
+            }
+
+            page = ghwp_page_new ();
+            ghwp_page_set_section (page, section);
+            g_ptr_array_add (pages, page);
+        }
+
+        /* 첫 페이지 표시 앞의 문단은 놓을 페이지가 없다 */
+        if (page)
             ghwp_page_add_paragraph (page, paragraph);
+    }
+
+    /* 섹션이 중간에 잘려 남은 표시가 있으면 그만큼 페이지가 줄어든다 */
+    _ghwp_document_set_section_pages (doc, index,
+                                      (GHWPPage **) pages->pdata, pages->len);
+    g_ptr_array_free (pages, TRUE);
+}
+
+/* 파일 속성만 보는 경우를 위해 문서를 열 때가 아니라 페이지가 처음
+ * 필요할 때 불린다. 섹션마다 레코드 인덱스로 페이지 수만 세어 페이지
+ * 표를 만들고, 섹션의 문단은 그 섹션의 페이지가 필요할 때 만든다. */
+static void _ghwp_file_v5_parse_body_text (GHWPDocument *doc, GError **error)
+{
+    g_return_if_fail (doc != NULL);
+    GHWPFileV5 *file = GHWP_FILE_V5(doc->file);
+    guint       n_sections = ghwp_file_v5_get_n_sections (file);
+    guint      *n_pages;
+    gdouble    *sizes;
+    guint       index;
+
+    g_array_set_size (doc->sections, n_sections);
+
+    /* 압축 풀기와 레코드 인덱스만 병렬로 하고, 객체는 페이지가 필요할 때
+     * 만든다 */
+    if ((ghwp_file_get_open_flags (doc->file) & GHWP_OPEN_PARALLEL) &&
+        n_sections > 1) {
+        if (!_ghwp_file_v5_build_sections_parallel (doc, FALSE, error))
+            return;
+    }
+
+    n_pages = g_new0 (guint, MAX (n_sections, 1));
+    sizes   = g_new0 (gdouble, MAX (n_sections, 1) * 2);
+
+    for (index = 0; index < n_sections; index++) {
+        GHWPRecordIndex *record_index;
+        ghwp_unit        h_size;
+        ghwp_unit        v_size;
+
+        if (g_cancellable_set_error_if_cancelled (
+                _ghwp_file_get_cancellable (doc->file), error)) {
+            g_free (n_pages);
+            g_free (sizes);
+            return;
+        }
+
+        /* 캐시에 인덱스가 없으면 섹션 전체의 압축을 한 번에 풀고 레코드
+         * 헤더를 훑는다 */
+        record_index = ghwp_file_v5_get_record_index (file, index, error);
+        if (record_index == NULL) {
+            g_free (n_pages);
+            g_free (sizes);
+            return;
+        }
+
+        n_pages[index] = ghwp_record_index_get_n_page_marks (record_index);
+        _ghwp_file_report_progress (doc->file, 0, 1, n_sections);
+
+        /* 용지 크기는 인덱스를 만들 때 읽어 두었다 */
+        ghwp_record_index_get_page_size (record_index, &h_size, &v_size);
+        sizes[index * 2]     = h_size / GHWP_UPP;
+        sizes[index * 2 + 1] = v_size / GHWP_UPP;
+    }
+
+    _ghwp_document_set_page_table (doc, n_pages, sizes, n_sections);
+    g_free (n_pages);
+    g_free (sizes);
+
+    for (index = 0; index < n_sections; index++) {
+        if (g_array_index (doc->sections, GHWPSection *, index))
+            _ghwp_file_v5_make_pages (doc, index);
+    }
+}
+
+/* 캐시에서 읽은 인덱스는 섹션을 실제로 풀었을 때 크기가 맞는지 본다.
+ * 맞지 않으면 섹션을 다시 훑어 인덱스를 바꾼다. */
+static GHWPRecordIndex *
+_ghwp_file_v5_check_record_index (GHWPFileV5 *file,
+                                  guint       index,
+                                  GBytes     *section_data,
+                                  GError    **error)
+{
+    GHWPRecordIndex *record_index;
+
+    record_index = g_ptr_array_index (file->priv->record_index, index);
+    if (record_index->priv->section_size == g_bytes_get_size (section_data))
+        return record_index;
+
+    record_index = ghwp_record_index_new (section_data, error);
+    if (record_index) {
+        g_object_unref (g_ptr_array_index (file->priv->record_index, index));
+        g_ptr_array_index (file->priv->record_index, index) = record_index;
+    }
+
+    return record_index;
+}
+
+/* 섹션의 문단을 만들고 그 섹션의 페이지를 채운다 */
+static gboolean ghwp_file_v5_build_section (GHWPFile     *hwp_file,
+                                            GHWPDocument *doc,
+                                            guint         index,
+                                            GError      **error)
+{
+    GHWPFileV5      *file = GHWP_FILE_V5 (hwp_file);
+    GHWPRecordIndex *record_index;
+    GBytes          *section_data;
+    GHWPSection     *section;
+
+    g_return_val_if_fail (index < doc->sections->len, FALSE);
+
+    if (g_array_index (doc->sections, GHWPSection *, index))
+        return TRUE;
+
+    /* 병렬로 열었으면 남은 섹션을 한꺼번에 만든다 */
+    if ((ghwp_file_get_open_flags (hwp_file) & GHWP_OPEN_PARALLEL) &&
+        doc->sections->len > 1) {
+        GPtrArray *built = g_ptr_array_new ();
+        guint      i;
+
+        for (i = 0; i < doc->sections->len; i++) {
+            if (g_array_index (doc->sections, GHWPSection *, i) == NULL)
+                g_ptr_array_add (built, GUINT_TO_POINTER (i));
+        }
+
+        if (!_ghwp_file_v5_build_sections_parallel (doc, TRUE, error)) {
+            g_ptr_array_free (built, TRUE);
+            return FALSE;
         }
+
+        for (i = 0; i < built->len; i++)
+            _ghwp_file_v5_make_pages (doc,
+                GPOINTER_TO_UINT (g_ptr_array_index (built, i)));
+
+        g_ptr_array_free (built, TRUE);
+        return TRUE;
+    }
+
+    /* 인덱스를 따라 메모리 위에서 레코드를 읽는다 */
+    record_index = ghwp_file_v5_get_record_index (file, index, error);
+    if (record_index == NULL)
+        return FALSE;
+
+    section_data = ghwp_file_v5_get_section_data (file, index, error);
+    if (section_data == NULL)
+        return FALSE;
+
+    record_index = _ghwp_file_v5_check_record_index (file, index,
+                                                     section_data, error);
+    if (record_index == NULL)
+        return FALSE;
+
+    section = _ghwp_file_v5_build_section (doc, section_data, record_index);
+    if (g_cancellable_set_error_if_cancelled (
+            _ghwp_file_get_cancellable (hwp_file), error)) {
+        _g_object_unref0 (section);
+        return FALSE;
     }
+    g_array_index (doc->sections, GHWPSection *, index) = section;
+    _ghwp_file_v5_drop_section_data (file, index);
+
+    _ghwp_file_v5_make_pages (doc, index);
+    return TRUE;
 }
 
 static void _ghwp_file_v5_parse_prv_text (GHWPDocument *doc)
@@ -358,16 +754,24 @@ static void _ghwp_file_v5_parse_prv_text (GHWPDocument *doc)
 
     GsfInputStream *gis   = _g_object_ref0 (GHWP_FILE_V5(doc->file)->prv_text_stream);
     gssize          size  = gsf_input_stream_size (gis);
-    guchar         *buf   = g_new (guchar, size);
+    const guint8   *buf   = NULL;
     GError         *error = NULL;
 
-    g_input_stream_read ((GInputStream*) gis, buf, size, NULL, &error);
+    /* 미리보기 텍스트가 비어 있다 */
+    if (size == 0) {
+        g_free (doc->prv_text);
+        doc->prv_text = g_strdup ("");
+        _g_object_unref0 (gis);
+        return;
+    }
 
-    if (error != NULL) {
-        g_warning("%s:%d: %s\n", __FILE__, __LINE__, error->message);
+    /* PrvText 는 압축되지 않으므로 복사하지 않고 바로 변환한다 */
+    if (size > 0)
+        buf = gsf_input_stream_borrow (gis, (gsize) size);
+
+    if (buf == NULL) {
+        g_warning("%s:%d: %s\n", __FILE__, __LINE__, "File corrupted");
         _g_free0 (doc->prv_text);
-        g_clear_error (&error);
-        buf = (g_free (buf), NULL);
         _g_object_unref0 (gis);
         return;
     }
@@ -381,12 +785,10 @@ static void _ghwp_file_v5_parse_prv_text (GHWPDocument *doc)
         g_warning("%s:%d: %s\n", __FILE__, __LINE__, error->message);
         _g_free0 (doc->prv_text);
         g_clear_error (&error);
-        buf = (g_free (buf), NULL);
         _g_object_unref0 (gis);
         return;
     }
 
-    buf = (g_free (buf), NULL);
     _g_object_unref0 (gis);
 }
 
@@ -545,27 +947,74 @@ static void _ghwp_file_v5_parse_summary_info (GHWPDocument *doc)
     _g_object_unref0 (gis);
 }
 
+/* 본문은 ghwp_document_load_body 에서 처음 필요할 때 읽는다 */
 static void _ghwp_file_v5_parse (GHWPDocument *doc, GError **error)
 {
     g_return_if_fail (doc != NULL);
 
-    _ghwp_file_v5_parse_doc_info (doc, error);
-    if (*error) return;
-    _ghwp_file_v5_parse_body_text (doc, error);
-    if (*error) return;
+    /* 메타데이터만 열었으면 DocInfo 스트림이 없다 */
+    if (GHWP_FILE_V5 (doc->file)->doc_info_stream) {
+        _ghwp_file_v5_parse_doc_info (doc, error);
+        if (*error) return;
+    }
     _ghwp_file_v5_parse_prv_text (doc);
     _ghwp_file_v5_parse_summary_info (doc);
 }
 
+/* 캐시에 없던 파일이면 파싱하면서 만든 레코드 인덱스를 저장한다 */
+static void _ghwp_file_v5_store_cache (GHWPFileV5 *file)
+{
+    GError *error = NULL;
+
+    if (file->priv->cache_path == NULL || file->priv->cache_hit ||
+        file->priv->cache_stored)
+        return;
+    if (file->priv->record_index == NULL ||
+        file->priv->record_index->len != ghwp_file_v5_get_n_sections (file))
+        return;
+
+    if (!_ghwp_cache_store (file->priv->cache_path, file->priv->record_index,
+                            file->priv->section_data, &error)) {
+        g_warning ("%s:%d: %s\n", __FILE__, __LINE__, error->message);
+        g_clear_error (&error);
+        return;
+    }
+
+    file->priv->cache_stored = TRUE;
+}
+
 GHWPDocument *ghwp_file_v5_get_document (GHWPFile *file, GError **error)
 {
     g_return_val_if_fail (GHWP_IS_FILE_V5 (file), NULL);
+    GError *tmp_error = NULL;
     GHWPDocument *doc = ghwp_document_new();
     doc->file = GHWP_FILE(file);
-    _ghwp_file_v5_parse (doc, error);
+    if (!(ghwp_file_get_open_flags (file) & GHWP_OPEN_METADATA_ONLY))
+        _ghwp_document_set_body_pending (doc);
+    _ghwp_file_v5_parse (doc, &tmp_error);
+    if (tmp_error)
+        g_propagate_error (error, tmp_error);
     return doc;
 }
 
+static gboolean ghwp_file_v5_parse_body (GHWPFile     *file,
+                                         GHWPDocument *doc,
+                                         GError      **error)
+{
+    GError *tmp_error = NULL;
+
+    g_return_val_if_fail (GHWP_IS_FILE_V5 (file), FALSE);
+
+    _ghwp_file_v5_parse_body_text (doc, &tmp_error);
+    if (tmp_error) {
+        g_propagate_error (error, tmp_error);
+        return FALSE;
+    }
+
+    _ghwp_file_v5_store_cache (GHWP_FILE_V5 (file));
+    return TRUE;
+}
+
 void
 ghwp_file_v5_get_hwp_version (GHWPFile *file,
                               guint8   *major_version,
@@ -608,19 +1057,15 @@ static void ghwp_file_v5_decode_file_header (GHWPFileV5 *file)
 
     GsfInputStream *gis;
     gssize          size;
-    gsize           bytes_read;
-    guint8         *buf;
+    const guint8   *buf;
     guint32         prop = 0;
 
+    /* FileHeader 는 압축되지 않으므로 복사하지 않고 읽는다 */
     gis  = (GsfInputStream *) g_object_ref (file->file_header_stream);
     size = gsf_input_stream_size (gis);
-    buf  = g_malloc (size);
-
-    g_input_stream_read_all ((GInputStream*) gis, buf, (gsize) size,
-                             &bytes_read, NULL, NULL);
-    g_object_unref (gis);
+    buf  = gsf_input_stream_borrow (gis, (gsize) size);
 
-    if (bytes_read >= 40) {
+    if (buf && size >= 40) {
         file->signature = g_strndup ((const gchar *)buf, 32); /* null로 끝남 */
         file->major_version = buf[35];
         file->minor_version = buf[34];
@@ -644,7 +1089,7 @@ static void ghwp_file_v5_decode_file_header (GHWPFileV5 *file)
         if (prop & (1 << 11)) file->is_ccl                 = TRUE;
     }
 
-    buf = (g_free (buf), NULL);
+    g_object_unref (gis);
 }
 
 
@@ -770,8 +1215,261 @@ static GArray *_ghwp_make_stream_array (GHWPFileV5 *file, char *name,
     return stream_array;
 }
 
+guint ghwp_file_v5_get_n_sections (GHWPFileV5 *file)
+{
+    g_return_val_if_fail (GHWP_IS_FILE_V5 (file), 0);
+
+    if (file->priv->body_text == NULL)
+        return 0;
+
+    return (guint) gsf_infile_num_children (file->priv->body_text);
+}
+
+/* deflate 는 한 바이트를 많아야 1032 바이트로 늘린다. 그보다 크게
+ * 풀리거나 섹션 하나가 GHWP_SECTION_MAX_SIZE 를 넘으면 깨진 파일로
+ * 본다. */
+#define GHWP_INFLATE_MAX_RATIO  1032
+
+/* 출력 버퍼를 limit 을 넘지 않게 두 배로 늘린다 */
+static gboolean _ghwp_inflate_grow (guint8 **buf, gsize *size, gsize limit,
+                                    GError **error)
+{
+    if (*size >= limit) {
+        g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                             _("File corrupted"));
+        return FALSE;
+    }
+
+    *size = *size > limit / 2 ? limit : *size * 2;
+    *buf  = g_realloc (*buf, *size);
+    return TRUE;
+}
+
+/* 압축된 섹션 전체를 한 번에 푼다. 출력 버퍼의 크기는 압축된 크기로부터
+ * 추정하고, 모자라면 두 배씩 늘린다. */
+static GBytes *_ghwp_inflate (const guint8 *raw, gsize raw_size,
+                              GError **error)
+{
+    GZlibDecompressor *zd;
+    GConverterResult   result;
+    gsize              limit;
+    gsize              size;
+    guint8            *buf;
+    gsize              in_pos  = 0;
+    gsize              out_pos = 0;
+
+    if (raw_size > (GHWP_SECTION_MAX_SIZE - 4096) / GHWP_INFLATE_MAX_RATIO)
+        limit = GHWP_SECTION_MAX_SIZE;
+    else
+        limit = raw_size * GHWP_INFLATE_MAX_RATIO + 4096;
+
+    size = MIN (MAX (raw_size, 1024) * 4, limit);
+    buf  = g_malloc (size);
+
+    zd = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+
+    do {
+        GError *tmp_error = NULL;
+        gsize   bytes_read;
+        gsize   bytes_written;
+
+        if (out_pos == size &&
+            !_ghwp_inflate_grow (&buf, &size, limit, error)) {
+            g_object_unref (zd);
+            g_free (buf);
+            return NULL;
+        }
+
+        result = g_converter_convert (G_CONVERTER (zd),
+                                      raw + in_pos, raw_size - in_pos,
+                                      buf + out_pos, size - out_pos,
+                                      G_CONVERTER_INPUT_AT_END,
+                                      &bytes_read, &bytes_written,
+                                      &tmp_error);
+
+        if (result == G_CONVERTER_ERROR) {
+            if (g_error_matches (tmp_error, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+                g_clear_error (&tmp_error);
+                if (_ghwp_inflate_grow (&buf, &size, limit, error))
+                    continue;
+
+                g_object_unref (zd);
+                g_free (buf);
+                return NULL;
+            }
+
+            g_propagate_error (error, tmp_error);
+            g_object_unref (zd);
+            g_free (buf);
+            return NULL;
+        }
+
+        in_pos  += bytes_read;
+        out_pos += bytes_written;
+    } while (result != G_CONVERTER_FINISHED);
+
+    g_object_unref (zd);
+
+    return g_bytes_new_take (g_realloc (buf, out_pos), out_pos);
+}
+
+static GBytes *_ghwp_file_v5_load_section (GHWPFileV5 *file,
+                                           guint       index,
+                                           GError    **error);
+
+/**
+ * ghwp_file_v5_get_section_data:
+ * @file: a #GHWPFileV5
+ * @index: the index of the section
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Returns the records of the section at @index as one contiguous,
+ * decompressed buffer. The section is inflated on the first call and
+ * kept for later calls, so it can be parsed again or accessed randomly,
+ * until the section is built into the pages of the document. Then it is
+ * dropped, unless it was mapped from the cache, and inflated again on
+ * the next call. Take a reference to keep it longer.
+ *
+ * Returns: (transfer none): a #GBytes, or %NULL on error
+ */
+GBytes *ghwp_file_v5_get_section_data (GHWPFileV5 *file,
+                                       guint       index,
+                                       GError    **error)
+{
+    GBytes *bytes;
+
+    g_return_val_if_fail (GHWP_IS_FILE_V5 (file), NULL);
+    g_return_val_if_fail (index < ghwp_file_v5_get_n_sections (file), NULL);
+
+    if (file->priv->section_data == NULL)
+        file->priv->section_data = g_ptr_array_new_with_free_func (
+                                       _g_bytes_unref0_);
+    if (file->priv->section_data->len < ghwp_file_v5_get_n_sections (file))
+        g_ptr_array_set_size (file->priv->section_data,
+                              ghwp_file_v5_get_n_sections (file));
+
+    bytes = g_ptr_array_index (file->priv->section_data, index);
+    if (bytes)
+        return bytes;
+
+    bytes = _ghwp_file_v5_load_section (file, index, error);
+    if (bytes)
+        g_ptr_array_index (file->priv->section_data, index) = bytes;
+
+    return bytes;
+}
+
+/* 캐시된 섹션이 있으면 그것을, 없으면 새로 읽어서 반환하되 캐시하지는
+ * 않는다. 문서 전체를 한 번 훑고 버리는 경우에 메모리를 아낀다. */
+GBytes *_ghwp_file_v5_ref_section_data (GHWPFileV5 *file,
+                                        guint       index,
+                                        GError    **error)
+{
+    g_return_val_if_fail (GHWP_IS_FILE_V5 (file), NULL);
+    g_return_val_if_fail (index < ghwp_file_v5_get_n_sections (file), NULL);
+
+    if (file->priv->section_data && index < file->priv->section_data->len &&
+        g_ptr_array_index (file->priv->section_data, index))
+        return g_bytes_ref (g_ptr_array_index (file->priv->section_data, index));
+
+    return _ghwp_file_v5_load_section (file, index, error);
+}
+
+/* 섹션 스트림을 압축을 풀지 않은 채로 읽는다 */
+static GBytes *_ghwp_file_v5_read_section (GHWPFileV5 *file,
+                                           guint       index,
+                                           GError    **error)
+{
+    GsfInput     *input;
+    gsf_off_t     size;
+    const guint8 *raw = NULL;
+    GBytes       *bytes;
+
+    input = gsf_infile_child_by_index (file->priv->body_text, index);
+    size  = gsf_input_size (input);
+
+    if (size > 0)
+        raw = gsf_input_read (input, (size_t) size, NULL);
+
+    if (size > 0 && raw == NULL) {
+        g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                             _("File corrupted"));
+        _g_object_unref0 (input);
+        return NULL;
+    }
+
+    bytes = g_bytes_new (raw, (gsize) MAX (size, 0));
+    _ghwp_file_report_progress (GHWP_FILE (file), (gsize) MAX (size, 0), 0,
+                                ghwp_file_v5_get_n_sections (file));
+
+    _g_object_unref0 (input);
+    return bytes;
+}
+
+/* 섹션 스트림을 읽고 필요하면 압축을 푼다 */
+static GBytes *_ghwp_file_v5_load_section (GHWPFileV5 *file,
+                                           guint       index,
+                                           GError    **error)
+{
+    GBytes *raw;
+    GBytes *bytes;
+    gsize   size;
+
+    raw = _ghwp_file_v5_read_section (file, index, error);
+    if (raw == NULL || !file->is_compress)
+        return raw;
+
+    bytes = _ghwp_inflate (g_bytes_get_data (raw, &size), size, error);
+    g_bytes_unref (raw);
+    return bytes;
+}
+
+/**
+ * ghwp_file_v5_get_record_index:
+ * @file: a #GHWPFileV5
+ * @index: the index of the section
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Returns the record index of the section at @index. The index is built
+ * from the record headers on the first call and kept for later calls.
+ *
+ * Returns: (transfer none): a #GHWPRecordIndex, or %NULL on error
+ */
+GHWPRecordIndex *ghwp_file_v5_get_record_index (GHWPFileV5 *file,
+                                                guint       index,
+                                                GError    **error)
+{
+    GHWPRecordIndex *record_index;
+    GBytes          *section_data;
+
+    g_return_val_if_fail (GHWP_IS_FILE_V5 (file), NULL);
+    g_return_val_if_fail (index < ghwp_file_v5_get_n_sections (file), NULL);
+
+    if (file->priv->record_index == NULL)
+        file->priv->record_index = g_ptr_array_new_with_free_func (
+                                       _g_object_unref0_);
+    if (file->priv->record_index->len < ghwp_file_v5_get_n_sections (file))
+        g_ptr_array_set_size (file->priv->record_index,
+                              ghwp_file_v5_get_n_sections (file));
+
+    record_index = g_ptr_array_index (file->priv->record_index, index);
+    if (record_index)
+        return record_index;
+
+    section_data = ghwp_file_v5_get_section_data (file, index, error);
+    if (section_data == NULL)
+        return NULL;
+
+    record_index = ghwp_record_index_new (section_data, error);
+    if (record_index)
+        g_ptr_array_index (file->priv->record_index, index) = record_index;
+
+    return record_index;
+}
+
 /* FIXME streams 배열과 enum을 이용하여 코드 재적성 바람 */
-static void _ghwp_file_v5_make_stream (GHWPFileV5 *file)
+/* metadata_only 이면 FileHeader, 요약 정보, 미리보기만 연다 */
+static void _ghwp_file_v5_make_stream (GHWPFileV5 *file, gboolean metadata_only)
 {
     g_return_if_fail (file != NULL);
 
@@ -801,25 +1499,29 @@ static void _ghwp_file_v5_make_stream (GHWPFileV5 *file)
             _g_object_unref0 (file->file_header_stream);
             file->file_header_stream = _ghwp_make_stream_single (file, entry, FALSE);
             ghwp_file_v5_decode_file_header (file);
-        } else if (g_str_equal (entry, "DocInfo")) {
-            _g_object_unref0 (file->doc_info_stream);
-            file->doc_info_stream = _ghwp_make_stream_single (file, entry, TRUE);
-        } else if (g_str_equal(entry, "BodyText") ||
-                   g_str_equal(entry, "ViewText")) {
-            _g_array_free0 (file->section_streams);
-            file->section_streams = _ghwp_make_stream_array (file, entry, TRUE);
         } else if (g_str_equal (entry, "\005HwpSummaryInformation")) {
             _g_object_unref0 (file->summary_info_stream);
             file->summary_info_stream = _ghwp_make_stream_single (file, entry, FALSE);
-        } else if (g_str_equal(entry, "BinData")) {
-            _g_array_free0 (file->bindata_streams);
-            file->bindata_streams = _ghwp_make_stream_array (file, entry, TRUE);
         } else if (g_str_equal (entry, "PrvText")) {
             _g_object_unref0 (file->prv_text_stream);
             file->prv_text_stream = _ghwp_make_stream_single (file, entry, FALSE);
         } else if (g_str_equal (entry, "PrvImage")) {
             _g_object_unref0 (file->prv_image_stream);
             file->prv_image_stream = _ghwp_make_stream_single (file, entry, FALSE);
+        } else if (metadata_only) {
+            continue;
+        } else if (g_str_equal (entry, "DocInfo")) {
+            _g_object_unref0 (file->doc_info_stream);
+            file->doc_info_stream = _ghwp_make_stream_single (file, entry, TRUE);
+        } else if (g_str_equal(entry, "BodyText") ||
+                   g_str_equal(entry, "ViewText")) {
+            _g_object_unref0 (file->priv->body_text);
+            file->priv->body_text = (GsfInfile *)
+                gsf_infile_child_by_name ((GsfInfile*) file->priv->olefile,
+                                          entry);
+        } else if (g_str_equal(entry, "BinData")) {
+            _g_array_free0 (file->bindata_streams);
+            file->bindata_streams = _ghwp_make_stream_array (file, entry, TRUE);
         } else {
             g_warning("%s:%d: %s not implemented\n", __FILE__, __LINE__, entry);
         } /* if */
@@ -828,41 +1530,176 @@ static void _ghwp_file_v5_make_stream (GHWPFileV5 *file)
     g_array_unref (entries);
 }
 
-GHWPFileV5* ghwp_file_v5_new_from_filename (const gchar* filename, GError** error)
+/* OLE 스트림을 압축을 풀지 않은 채로 읽는다 */
+static GBytes *_ghwp_file_v5_read_raw (GHWPFileV5 *file, const gchar *name)
 {
-    g_return_val_if_fail (filename != NULL, NULL);
-    GFile *gfile = g_file_new_for_path (filename);
+    GsfInput     *input;
+    gsf_off_t     size;
+    const guint8 *raw = NULL;
+    GBytes       *bytes = NULL;
 
-    GsfInputStdio* input;
-    GsfInfileMSOle* olefile;
+    input = gsf_infile_child_by_name ((GsfInfile *) file->priv->olefile, name);
+    if (input == NULL)
+        return NULL;
 
-    gchar *path = g_file_get_path(gfile);
-    _g_object_unref0 (gfile);
-    input = (GsfInputStdio*) gsf_input_stdio_new (path, error);
-    _g_free0 (path);
+    size = gsf_input_size (input);
+    if (size > 0)
+        raw = gsf_input_read (input, (size_t) size, NULL);
+    if (raw)
+        bytes = g_bytes_new (raw, (gsize) size);
 
-    if (input == NULL) {
-        g_warning("%s:%d: %s\n", __FILE__, __LINE__, (*error)->message);
-        return NULL;
-    }
+    _g_object_unref0 (input);
+    return bytes;
+}
+
+/* 캐시 디렉토리가 설정되어 있으면 레코드 인덱스와 섹션을 캐시에서 찾는다.
+ * 파일 크기, 수정 시각과 FileHeader, DocInfo 스트림의 해시가 키이다. */
+static void _ghwp_file_v5_load_cache (GHWPFileV5 *file, const gchar *filename)
+{
+    GBytes    *file_header;
+    GBytes    *doc_info;
+    GPtrArray *record_index;
+    GPtrArray *section_data;
+    guint      i;
+
+    if (file->priv->body_text == NULL)
+        return;
+
+    file_header = _ghwp_file_v5_read_raw (file, "FileHeader");
+    doc_info    = _ghwp_file_v5_read_raw (file, "DocInfo");
 
-    olefile = (GsfInfileMSOle*) gsf_infile_msole_new ((GsfInput*) input,
-                                                      error);
+    file->priv->cache_path = _ghwp_cache_get_path (filename, file_header,
+                                                   doc_info);
+    if (file_header) g_bytes_unref (file_header);
+    if (doc_info)    g_bytes_unref (doc_info);
+
+    if (file->priv->cache_path == NULL)
+        return;
+
+    if (!_ghwp_cache_load (file->priv->cache_path,
+                           ghwp_file_v5_get_n_sections (file),
+                           &record_index, &section_data))
+        return;
+
+    if (file->priv->record_index)
+        g_ptr_array_unref (file->priv->record_index);
+    if (file->priv->section_data)
+        g_ptr_array_unref (file->priv->section_data);
+
+    file->priv->record_index = record_index;
+    file->priv->section_data = section_data;
+    file->priv->cache_hit    = TRUE;
+
+    g_free (file->priv->section_cached);
+    file->priv->section_cached = g_new0 (gboolean, section_data->len);
+    for (i = 0; i < section_data->len; i++)
+        file->priv->section_cached[i] =
+            g_ptr_array_index (section_data, i) != NULL;
+}
+
+/* 메모리 위의 OLE 컨테이너를 복사하지 않고 열고 스트림을 만든다.
+ * filename 이 있으면 그 파일의 캐시를 찾는다. */
+GHWPFileV5 *_ghwp_file_v5_new_from_mapping (GBytes        *bytes,
+                                            const gchar   *filename,
+                                            GHWPOpenFlags  flags,
+                                            GError       **error)
+{
+    GsfInput       *input;
+    GsfInfileMSOle *olefile;
+    GHWPFileV5     *file;
+    const guint8   *data;
+    gsize           size;
+    GError         *tmp_error = NULL;
+
+    data  = g_bytes_get_data (bytes, &size);
+    input = gsf_input_memory_new (data, (gsf_off_t) size, FALSE);
+
+    olefile = (GsfInfileMSOle*) gsf_infile_msole_new (input, &tmp_error);
+    _g_object_unref0 (input);
 
     if (olefile == NULL) {
-        g_warning("%s:%d: %s\n", __FILE__, __LINE__, (*error)->message);
-        _g_object_unref0 (input);
+        g_warning("%s:%d: %s\n", __FILE__, __LINE__, tmp_error->message);
+        g_propagate_error (error, tmp_error);
         return NULL;
     }
 
-    GHWPFileV5 *file = g_object_new (GHWP_TYPE_FILE_V5, NULL);
+    file = g_object_new (GHWP_TYPE_FILE_V5, NULL);
     file->priv->olefile = olefile;
-    _g_object_unref0 (input);
-    _ghwp_file_v5_make_stream (file);
+    file->priv->bytes   = g_bytes_ref (bytes);
+    GHWP_FILE (file)->priv->flags = flags;
+    _ghwp_file_v5_make_stream (file, flags & GHWP_OPEN_METADATA_ONLY);
+
+    if (filename && !(flags & GHWP_OPEN_METADATA_ONLY))
+        _ghwp_file_v5_load_cache (file, filename);
+
+    return file;
+}
+
+GHWPFileV5* ghwp_file_v5_new_from_filename (const gchar* filename, GError** error)
+{
+    return ghwp_file_v5_new_from_filename_full (filename, GHWP_OPEN_NONE, error);
+}
+
+/**
+ * ghwp_file_v5_new_from_filename_full:
+ * @filename: path of the file to load
+ * @flags: #GHWPOpenFlags to load the file with
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Like ghwp_file_v5_new_from_filename(), but with %GHWP_OPEN_METADATA_ONLY
+ * in @flags only the streams needed for the metadata are opened.
+ *
+ * Returns: A newly created #GHWPFileV5, or %NULL
+ */
+GHWPFileV5* ghwp_file_v5_new_from_filename_full (const gchar   *filename,
+                                                 GHWPOpenFlags  flags,
+                                                 GError       **error)
+{
+    GMappedFile *mapped;
+    GBytes      *bytes;
+    GHWPFileV5  *file;
+    GError      *tmp_error = NULL;
+
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    /* stdio 로 섹터마다 읽어 복사하지 않고 파일을 매핑한다 */
+    mapped = g_mapped_file_new (filename, FALSE, &tmp_error);
+    if (mapped == NULL) {
+        g_warning("%s:%d: %s\n", __FILE__, __LINE__, tmp_error->message);
+        g_propagate_error (error, tmp_error);
+        return NULL;
+    }
+
+    bytes = g_mapped_file_get_bytes (mapped);
+    g_mapped_file_unref (mapped);
+
+    file = _ghwp_file_v5_new_from_mapping (bytes, filename, flags, error);
+    g_bytes_unref (bytes);
 
     return file;
 }
 
+/**
+ * ghwp_file_v5_new_from_bytes:
+ * @bytes: a #GBytes holding the whole file
+ * @flags: #GHWPOpenFlags to load the file with
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Opens a v5 file that is already in memory. The OLE container is read
+ * from @bytes in place without copying it, and @bytes is referenced for
+ * as long as the file is alive. The on-disk cache is not used.
+ *
+ * Returns: A newly created #GHWPFileV5, or %NULL
+ */
+GHWPFileV5 *ghwp_file_v5_new_from_bytes (GBytes        *bytes,
+                                         GHWPOpenFlags  flags,
+                                         GError       **error)
+{
+    g_return_val_if_fail (bytes != NULL, NULL);
+
+    return _ghwp_file_v5_new_from_mapping (bytes, NULL, flags, error);
+}
+
 static void ghwp_file_v5_finalize (GObject* obj)
 {
     GHWPFileV5 *file = GHWP_FILE_V5(obj);
@@ -871,8 +1708,16 @@ static void ghwp_file_v5_finalize (GObject* obj)
     _g_object_unref0 (file->prv_image_stream);
     _g_object_unref0 (file->file_header_stream);
     _g_object_unref0 (file->doc_info_stream);
-    _g_array_free0 (file->section_streams);
     _g_object_unref0 (file->priv->section_stream);
+    _g_object_unref0 (file->priv->body_text);
+    if (file->priv->section_data)
+        g_ptr_array_unref (file->priv->section_data);
+    g_free (file->priv->section_cached);
+    if (file->priv->record_index)
+        g_ptr_array_unref (file->priv->record_index);
+    _g_free0 (file->priv->cache_path);
+    if (file->priv->bytes)
+        g_bytes_unref (file->priv->bytes);
     _g_object_unref0 (file->summary_info_stream);
     g_free (file->signature);
     G_OBJECT_CLASS (ghwp_file_v5_parent_class)->finalize (obj);
@@ -883,6 +1728,8 @@ static void ghwp_file_v5_class_init (GHWPFileV5Class * klass)
     GObjectClass *object_class = G_OBJECT_CLASS (klass);
     g_type_class_add_private (klass, sizeof (GHWPFileV5Private));
     GHWP_FILE_CLASS (klass)->get_document = ghwp_file_v5_get_document;
+    GHWP_FILE_CLASS (klass)->parse_body = ghwp_file_v5_parse_body;
+    GHWP_FILE_CLASS (klass)->build_section = ghwp_file_v5_build_section;
     GHWP_FILE_CLASS (klass)->get_hwp_version_string = ghwp_file_v5_get_hwp_version_string;
     GHWP_FILE_CLASS (klass)->get_hwp_version = ghwp_file_v5_get_hwp_version;
     object_class->finalize = ghwp_file_v5_finalize;
@@ -51,7 +51,6 @@ struct _GHWPFileV5
     GHWPFile           parent_instance;
     GHWPFileV5Private *priv;
 
-    GArray            *section_streams;
     GArray            *bindata_streams;
     GInputStream      *prv_text_stream;
     GInputStream      *prv_image_stream;
@@ -87,6 +86,14 @@ struct _GHWPFileV5Private
 {
     GsfInfileMSOle *olefile;
     GInputStream   *section_stream;
+    GsfInfile      *body_text;     /* BodyText 또는 ViewText */
+    GPtrArray      *section_data;  /* 압축을 푼 섹션, GBytes, 만들면 버린다 */
+    gboolean       *section_cached; /* 섹션마다 바이트가 캐시 파일에서 왔다 */
+    GPtrArray      *record_index;  /* 섹션별 GHWPRecordIndex */
+    gchar          *cache_path;    /* 캐시를 쓰지 않으면 NULL */
+    GBytes         *bytes;         /* 메모리에서 열었으면 파일 전체 */
+    gboolean        cache_hit;     /* 인덱스를 캐시에서 읽었다 */
+    gboolean        cache_stored;  /* 만든 인덱스를 캐시에 저장했다 */
 };
 
 GType         ghwp_file_v5_get_type               (void) G_GNUC_CONST;
@@ -94,6 +101,12 @@ GHWPFileV5   *ghwp_file_v5_new_from_uri           (const gchar *uri,
                                                    GError     **error);
 GHWPFileV5   *ghwp_file_v5_new_from_filename      (const gchar *filename,
                                                    GError     **error);
+GHWPFileV5   *ghwp_file_v5_new_from_filename_full (const gchar  *filename,
+                                                   GHWPOpenFlags flags,
+                                                   GError      **error);
+GHWPFileV5   *ghwp_file_v5_new_from_bytes         (GBytes       *bytes,
+                                                   GHWPOpenFlags flags,
+                                                   GError      **error);
 gchar        *ghwp_file_v5_get_hwp_version_string (GHWPFile    *file);
 void          ghwp_file_v5_get_hwp_version        (GHWPFile    *file,
                                                    guint8      *major_version,
@@ -102,6 +115,14 @@ void          ghwp_file_v5_get_hwp_version        (GHWPFile    *file,
                                                    guint8      *extra_version);
 GHWPDocument *ghwp_file_v5_get_document           (GHWPFile    *file,
                                                    GError     **error);
+guint         ghwp_file_v5_get_n_sections         (GHWPFileV5  *file);
+GBytes       *ghwp_file_v5_get_section_data       (GHWPFileV5  *file,
+                                                   guint        index,
+                                                   GError     **error);
+GHWPRecordIndex *
+              ghwp_file_v5_get_record_index       (GHWPFileV5  *file,
+                                                   guint        index,
+                                                   GError     **error);
 
 G_END_DECLS
 
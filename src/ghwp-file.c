@@ -33,9 +33,12 @@
 #include "ghwp-file-v5.h"
 #include "ghwp-file-v3.h"
 #include "ghwp-file-ml.h"
+#include "ghwp-private.h"
 
 G_DEFINE_ABSTRACT_TYPE (GHWPFile, ghwp_file, G_TYPE_OBJECT);
 
+#define _g_object_unref0(var) ((var == NULL) ? NULL : (var = (g_object_unref (var), NULL)))
+
 /**
  * ghwp_file_error_quark
  *
@@ -88,6 +91,19 @@ GHWPFile *ghwp_file_new_from_uri (const gchar* uri, GError** error)
     return file;
 }
 
+/* check signature */
+static const guint8 signature_ole[] = {
+    0xd0, 0xcf, 0x11, 0xe0, 0xa1, 0xb1, 0x1a, 0xe1
+};
+
+static const guint8 signature_v3[] = {
+    /* HWP Document File V3.00 \x1a\1\2\3\4\5 */
+    0x48, 0x57, 0x50, 0x20, 0x44, 0x6f, 0x63, 0x75,
+    0x6d, 0x65, 0x6e, 0x74, 0x20, 0x46, 0x69, 0x6c,
+    0x65, 0x20, 0x56, 0x33, 0x2e, 0x30, 0x30, 0x20,
+    0x1a, 0x01, 0x02, 0x03, 0x04, 0x05
+};
+
 static gboolean is_hwpml (gchar *haystack, gssize haystack_len)
 {
     gchar *ptr1;
@@ -109,61 +125,390 @@ static gboolean is_hwpml (gchar *haystack, gssize haystack_len)
         return FALSE;
 }
 
-GHWPFile *ghwp_file_new_from_filename (const gchar* filename, GError** error)
+/* 열린 파일에 옵션을 붙인다. 그 사이에 취소되었으면 파일을 버린다. */
+static GHWPFile *ghwp_file_set_options (GHWPFile      *hwp_file,
+                                        GHWPOpenFlags  flags,
+                                        GCancellable  *cancellable,
+                                        GError       **error)
 {
-    g_return_val_if_fail (filename != NULL, NULL);
+    if (hwp_file == NULL)
+        return NULL;
 
-    /* check signature */
-	static const guint8 signature_ole[] = {
-        0xd0, 0xcf, 0x11, 0xe0, 0xa1, 0xb1, 0x1a, 0xe1
-    };
+    hwp_file->priv->flags = flags;
+    if (cancellable)
+        hwp_file->priv->cancellable = g_object_ref (cancellable);
 
-	static const guint8 signature_v3[] = {
-        /* HWP Document File V3.00 \x1a\1\2\3\4\5 */
-        0x48, 0x57, 0x50, 0x20, 0x44, 0x6f, 0x63, 0x75,
-        0x6d, 0x65, 0x6e, 0x74, 0x20, 0x46, 0x69, 0x6c,
-        0x65, 0x20, 0x56, 0x33, 0x2e, 0x30, 0x30, 0x20,
-        0x1a, 0x01, 0x02, 0x03, 0x04, 0x05
-    };
+    if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        _g_object_unref0 (hwp_file);
 
-    GFile            *file   = g_file_new_for_path (filename);
-    GFileInputStream *stream = g_file_read(file, NULL, error);
+    return hwp_file;
+}
 
-    if (!stream)
-        return NULL;
+/* 메모리에 있는 파일의 시그너처를 보고 알맞은 파일 객체를 만든다.
+ * filename 은 파일에서 매핑했을 때만 주며, v5 캐시의 키로 쓴다. */
+static GHWPFile *ghwp_file_new_from_mapping (GBytes        *bytes,
+                                             const gchar   *filename,
+                                             GHWPOpenFlags  flags,
+                                             GCancellable  *cancellable,
+                                             GError       **error)
+{
+    GHWPFile     *hwp_file = NULL;
+    const guint8 *data;
+    gsize         size;
 
-    gsize bytes_read = 0;
-    guint8 *buffer = g_malloc0 (4096);
-    g_input_stream_read_all (G_INPUT_STREAM(stream), buffer, 4096,
-                             &bytes_read, NULL, error);
+    data = g_bytes_get_data (bytes, &size);
 
-    if ( memcmp(buffer, signature_ole, sizeof(signature_ole)) == 0) {
+    if (size >= sizeof (signature_ole) &&
+        memcmp (data, signature_ole, sizeof (signature_ole)) == 0) {
         /* hwp v5 */
-        g_free(buffer);
-        g_object_unref(stream);
-        return GHWP_FILE (ghwp_file_v5_new_from_filename (filename, error));
-    } else if ( memcmp(buffer, signature_v3, sizeof(signature_v3)) == 0) {
+        hwp_file = GHWP_FILE (_ghwp_file_v5_new_from_mapping (bytes, filename,
+                                                              flags, error));
+    } else if (size >= sizeof (signature_v3) &&
+               memcmp (data, signature_v3, sizeof (signature_v3)) == 0) {
         /* hwp v3 */
-        g_free(buffer);
-        g_object_unref(stream);
-        return GHWP_FILE (ghwp_file_v3_new_from_filename (filename, error));
-    } else if (is_hwpml((gchar *) buffer, bytes_read)) {
+        hwp_file = GHWP_FILE (ghwp_file_v3_new_from_bytes (bytes, error));
+    } else if (size > 0 && is_hwpml ((gchar *) data, MIN (size, 4096))) {
         /* hwp ml */
-        g_free(buffer);
-        g_object_unref(stream);
-        return GHWP_FILE (ghwp_file_ml_new_from_filename (filename, error));
+        hwp_file = GHWP_FILE (ghwp_file_ml_new_from_bytes (bytes, error));
     } else {
         /* invalid hwp file */
-        *error = g_error_new (ghwp_file_error_quark(), GHWP_FILE_ERROR_INVALID,
-                              "invalid hwp file");
-        g_free(buffer);
-        g_object_unref(stream);
+        g_set_error_literal (error, ghwp_file_error_quark (),
+                             GHWP_FILE_ERROR_INVALID, "invalid hwp file");
+        return NULL;
+    }
+
+    return ghwp_file_set_options (hwp_file, flags, cancellable, error);
+}
+
+GHWPFile *ghwp_file_new_from_filename (const gchar* filename, GError** error)
+{
+    return ghwp_file_new_from_filename_full (filename, GHWP_OPEN_NONE, NULL,
+                                             error);
+}
+
+/**
+ * ghwp_file_new_from_filename_full:
+ * @filename: path of the file to load
+ * @flags: #GHWPOpenFlags to load the file with
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Like ghwp_file_new_from_filename(), but @flags are used when the
+ * document is read from the file. If @cancellable is cancelled while the
+ * file is opened, or later while its document info, body text or
+ * pictures are read, that operation fails with %G_IO_ERROR_CANCELLED.
+ *
+ * Returns: A newly created #GHWPFile, or %NULL
+ */
+GHWPFile *ghwp_file_new_from_filename_full (const gchar   *filename,
+                                            GHWPOpenFlags  flags,
+                                            GCancellable  *cancellable,
+                                            GError       **error)
+{
+    GMappedFile *mapped;
+    GBytes      *bytes;
+    GHWPFile    *hwp_file;
+
+    g_return_val_if_fail (filename != NULL, NULL);
+
+    if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        return NULL;
+
+    /* 파일은 한 번만 열어서 매핑하고, 시그너처 확인과 파싱 모두
+     * 매핑된 메모리에서 한다 */
+    mapped = g_mapped_file_new (filename, FALSE, error);
+    if (mapped == NULL)
+        return NULL;
+
+    bytes = g_mapped_file_get_bytes (mapped);
+    g_mapped_file_unref (mapped);
+
+    hwp_file = ghwp_file_new_from_mapping (bytes, filename, flags,
+                                           cancellable, error);
+    g_bytes_unref (bytes);
+
+    return hwp_file;
+}
+
+/**
+ * ghwp_file_new_from_bytes:
+ * @bytes: a #GBytes holding the whole file
+ * @flags: #GHWPOpenFlags to load the file with
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Creates a new #GHWPFile from a file that is already in memory. The data
+ * is not copied; @bytes is referenced for as long as the file is alive.
+ * @flags and @cancellable are used as in
+ * ghwp_file_new_from_filename_full().
+ *
+ * Returns: A newly created #GHWPFile, or %NULL
+ */
+GHWPFile *ghwp_file_new_from_bytes (GBytes        *bytes,
+                                    GHWPOpenFlags  flags,
+                                    GCancellable  *cancellable,
+                                    GError       **error)
+{
+    g_return_val_if_fail (bytes != NULL, NULL);
+
+    if (g_cancellable_set_error_if_cancelled (cancellable, error))
         return NULL;
+
+    return ghwp_file_new_from_mapping (bytes, NULL, flags, cancellable,
+                                       error);
+}
+
+/**
+ * ghwp_file_new_from_stream:
+ * @stream: a #GInputStream to read the file from
+ * @flags: #GHWPOpenFlags to load the file with
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Creates a new #GHWPFile from the data read from @stream up to its end.
+ * The data is kept in memory, see ghwp_file_new_from_bytes().
+ *
+ * Returns: A newly created #GHWPFile, or %NULL
+ */
+GHWPFile *ghwp_file_new_from_stream (GInputStream  *stream,
+                                     GHWPOpenFlags  flags,
+                                     GCancellable  *cancellable,
+                                     GError       **error)
+{
+    GOutputStream *output;
+    GBytes        *bytes;
+    GHWPFile      *hwp_file;
+
+    g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+    output = g_memory_output_stream_new_resizable ();
+    if (g_output_stream_splice (output, stream,
+                                G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                cancellable, error) < 0) {
+        g_object_unref (output);
+        return NULL;
+    }
+
+    bytes = g_memory_output_stream_steal_as_bytes (
+                G_MEMORY_OUTPUT_STREAM (output));
+    g_object_unref (output);
+
+    hwp_file = ghwp_file_new_from_bytes (bytes, flags, cancellable, error);
+    g_bytes_unref (bytes);
+
+    return hwp_file;
+}
+
+/* 로컬 파일은 매핑해서 열고, 그렇지 않으면 스트림으로 끝까지 읽어서
+ * 연다 */
+GHWPFile *_ghwp_file_new_from_gfile (GFile         *file,
+                                     GHWPOpenFlags  flags,
+                                     GCancellable  *cancellable,
+                                     GError       **error)
+{
+    GFileInputStream *stream;
+    GHWPFile         *hwp_file;
+    gchar            *filename;
+
+    g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+    filename = g_file_get_path (file);
+    if (filename) {
+        hwp_file = ghwp_file_new_from_filename_full (filename, flags,
+                                                     cancellable, error);
+        g_free (filename);
+        return hwp_file;
     }
+
+    stream = g_file_read (file, cancellable, error);
+    if (stream == NULL)
+        return NULL;
+
+    hwp_file = ghwp_file_new_from_stream (G_INPUT_STREAM (stream), flags,
+                                          cancellable, error);
+    g_object_unref (stream);
+
+    return hwp_file;
+}
+
+typedef struct
+{
+    GFile         *file;
+    GHWPOpenFlags  flags;
+} GHWPFileOpenData;
+
+static void ghwp_file_open_data_free (gpointer data)
+{
+    GHWPFileOpenData *open_data = data;
+
+    g_object_unref (open_data->file);
+    g_free (open_data);
+}
+
+static void ghwp_file_open_thread (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable)
+{
+    GHWPFileOpenData *open_data = task_data;
+    GHWPFile         *file;
+    GError           *error = NULL;
+
+    file = _ghwp_file_new_from_gfile (open_data->file, open_data->flags,
+                                      cancellable, &error);
+    if (file == NULL) {
+        if (error == NULL)
+            error = g_error_new_literal (ghwp_file_error_quark (),
+                                         GHWP_FILE_ERROR_INVALID,
+                                         "invalid hwp file");
+        g_task_return_error (task, error);
+        return;
+    }
+
+    g_task_return_pointer (task, file, g_object_unref);
+}
+
+/**
+ * ghwp_file_new_from_file_async:
+ * @file: a #GFile to load
+ * @flags: #GHWPOpenFlags to load the file with
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the file is opened
+ * @user_data: data to pass to @callback
+ *
+ * Opens @file in a worker thread, like ghwp_file_new_from_filename_full().
+ * @callback is called in the thread-default main context of the caller;
+ * call ghwp_file_new_from_file_finish() from it to get the result.
+ * A local file is mapped; any other #GFile is read into memory with
+ * g_file_read(), see ghwp_file_new_from_stream().
+ */
+void ghwp_file_new_from_file_async (GFile              *file,
+                                    GHWPOpenFlags       flags,
+                                    GCancellable       *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer            user_data)
+{
+    GHWPFileOpenData *open_data;
+    GTask            *task;
+
+    g_return_if_fail (G_IS_FILE (file));
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_source_tag (task, ghwp_file_new_from_file_async);
+
+    open_data = g_new0 (GHWPFileOpenData, 1);
+    open_data->file  = g_object_ref (file);
+    open_data->flags = flags;
+    g_task_set_task_data (task, open_data, ghwp_file_open_data_free);
+
+    g_task_run_in_thread (task, ghwp_file_open_thread);
+    g_object_unref (task);
+}
+
+/**
+ * ghwp_file_new_from_file_finish:
+ * @result: the #GAsyncResult passed to the callback
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Finishes an operation started with ghwp_file_new_from_file_async().
+ *
+ * Returns: (transfer full): A newly created #GHWPFile, or %NULL on error
+ */
+GHWPFile *ghwp_file_new_from_file_finish (GAsyncResult *result,
+                                          GError      **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+GHWPOpenFlags ghwp_file_get_open_flags (GHWPFile *file)
+{
+    g_return_val_if_fail (GHWP_IS_FILE (file), GHWP_OPEN_NONE);
+
+    return file->priv->flags;
+}
+
+/**
+ * ghwp_file_set_progress_callback:
+ * @file: a #GHWPFile
+ * @func: (allow-none): a #GHWPProgressFunc, or %NULL to remove it
+ * @user_data: data to pass to @func
+ * @notify: (allow-none): function to free @user_data, or %NULL
+ *
+ * Sets a callback that is called as the body text of the document of
+ * @file is read and parsed. It is called on the thread that loads the
+ * document, also when %GHWP_OPEN_PARALLEL is used.
+ */
+void ghwp_file_set_progress_callback (GHWPFile        *file,
+                                      GHWPProgressFunc func,
+                                      gpointer         user_data,
+                                      GDestroyNotify   notify)
+{
+    g_return_if_fail (GHWP_IS_FILE (file));
+
+    if (file->priv->progress_notify)
+        file->priv->progress_notify (file->priv->progress_data);
+
+    file->priv->progress        = func;
+    file->priv->progress_data   = user_data;
+    file->priv->progress_notify = notify;
+}
+
+GCancellable *_ghwp_file_get_cancellable (GHWPFile *file)
+{
+    g_return_val_if_fail (GHWP_IS_FILE (file), NULL);
+
+    return file->priv->cancellable;
+}
+
+/* 본문을 읽기 시작할 때 진행 상황을 0 부터 다시 센다 */
+void _ghwp_file_begin_progress (GHWPFile *file)
+{
+    g_return_if_fail (GHWP_IS_FILE (file));
+
+    file->priv->bytes_read      = 0;
+    file->priv->n_sections_done = 0;
+    file->priv->loading         = TRUE;
+}
+
+void _ghwp_file_end_progress (GHWPFile *file)
+{
+    g_return_if_fail (GHWP_IS_FILE (file));
+
+    file->priv->loading = FALSE;
+}
+
+/* 읽은 바이트와 끝낸 섹션 수를 더해서 알린다. 본문을 읽은 뒤에
+ * 섹션을 다시 읽는 것 (걷기, 텍스트 쓰기, 검색 색인, 페이지) 은 세지
+ * 않는다. */
+void _ghwp_file_report_progress (GHWPFile *file,
+                                 gsize     bytes_read,
+                                 guint     n_sections_done,
+                                 guint     n_sections)
+{
+    g_return_if_fail (GHWP_IS_FILE (file));
+
+    if (!file->priv->loading)
+        return;
+
+    file->priv->bytes_read      += bytes_read;
+    file->priv->n_sections_done += n_sections_done;
+
+    if (file->priv->progress)
+        file->priv->progress (file->priv->bytes_read,
+                              file->priv->n_sections_done, n_sections,
+                              file->priv->progress_data);
 }
 
 static void ghwp_file_finalize (GObject *obj)
 {
+    GHWPFile *file = GHWP_FILE (obj);
+
+    if (file->priv->progress_notify)
+        file->priv->progress_notify (file->priv->progress_data);
+    _g_object_unref0 (file->priv->cancellable);
+
     G_OBJECT_CLASS (ghwp_file_parent_class)->finalize (obj);
 }
 
@@ -73,6 +73,13 @@ struct _GHWPFile {
 struct _GHWPFileClass {
     GObjectClass parent_class;
     GHWPDocument* (*get_document) (GHWPFile *file, GError **error);
+    gboolean      (*parse_body)   (GHWPFile     *file,
+                                   GHWPDocument *doc,
+                                   GError      **error);
+    gboolean      (*build_section) (GHWPFile     *file,
+                                    GHWPDocument *doc,
+                                    guint         index,
+                                    GError      **error);
     gchar* (*get_hwp_version_string) (GHWPFile* file);
     void   (*get_hwp_version) (GHWPFile *file,
                                guint8   *major_version,
@@ -82,8 +89,16 @@ struct _GHWPFileClass {
 };
 
 struct _GHWPFilePrivate {
-    GsfInfileMSOle *olefile;
-    GInputStream   *section_stream;
+    GsfInfileMSOle   *olefile;
+    GInputStream     *section_stream;
+    GHWPOpenFlags     flags;
+    GCancellable     *cancellable;
+    GHWPProgressFunc  progress;
+    gpointer          progress_data;
+    GDestroyNotify    progress_notify;
+    guint64           bytes_read;      /* 진행 상황으로 알린 바이트 수 */
+    guint             n_sections_done;
+    gboolean          loading;         /* 본문을 읽는 중에만 알린다 */
 };
 
 GType         ghwp_file_get_type          (void) G_GNUC_CONST;
@@ -92,6 +107,34 @@ GHWPFile*     ghwp_file_new_from_uri      (const gchar* uri,
                                            GError**     error);
 GHWPFile*     ghwp_file_new_from_filename (const gchar* filename,
                                            GError**     error);
+GHWPFile*     ghwp_file_new_from_bytes    (GBytes       *bytes,
+                                           GHWPOpenFlags flags,
+                                           GCancellable *cancellable,
+                                           GError      **error);
+GHWPFile*     ghwp_file_new_from_stream   (GInputStream *stream,
+                                           GHWPOpenFlags flags,
+                                           GCancellable *cancellable,
+                                           GError      **error);
+GHWPFile*     ghwp_file_new_from_filename_full
+                                          (const gchar*  filename,
+                                           GHWPOpenFlags flags,
+                                           GCancellable* cancellable,
+                                           GError**      error);
+void          ghwp_file_new_from_file_async
+                                          (GFile              *file,
+                                           GHWPOpenFlags       flags,
+                                           GCancellable       *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer            user_data);
+GHWPFile*     ghwp_file_new_from_file_finish
+                                          (GAsyncResult       *result,
+                                           GError            **error);
+GHWPOpenFlags ghwp_file_get_open_flags    (GHWPFile    *file);
+void          ghwp_file_set_progress_callback
+                                          (GHWPFile        *file,
+                                           GHWPProgressFunc func,
+                                           gpointer         user_data,
+                                           GDestroyNotify   notify);
 GHWPDocument *ghwp_file_get_document      (GHWPFile    *file,
                                            GError     **error);
 gchar*        ghwp_file_get_hwp_version_string (GHWPFile* self);
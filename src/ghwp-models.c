@@ -25,31 +25,41 @@
  * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
  */
 
+#include <string.h>
 #include <glib/gprintf.h>
 
 #include "ghwp-models.h"
 #include "ghwp-parse.h"
 #include "ghwp-document.h"
+#include "ghwp-utf16.h"
+#include "ghwp-text-arena.h"
+#include "ghwp-private.h"
 
 #define _g_object_unref0(var) ((var == NULL) ? NULL : (var = (g_object_unref (var), NULL)))
 #define _g_free0(var) (var = (g_free (var), NULL))
 
+/* 개체 공통 속성 */
+static const GHWPField common_object_fields[] = {
+    GHWP_FIELD (GHWPObject, attr,        GHWP_U32),
+    GHWP_FIELD (GHWPObject, v_offset,    GHWP_U32),
+    GHWP_FIELD (GHWPObject, h_offset,    GHWP_U32),
+    GHWP_FIELD (GHWPObject, width,       GHWP_U32),
+    GHWP_FIELD (GHWPObject, height,      GHWP_U32),
+    GHWP_FIELD (GHWPObject, z_order,     GHWP_I32),
+    GHWP_FIELD (GHWPObject, l_spacing,   GHWP_U16),
+    GHWP_FIELD (GHWPObject, r_spacing,   GHWP_U16),
+    GHWP_FIELD (GHWPObject, t_spacing,   GHWP_U16),
+    GHWP_FIELD (GHWPObject, b_spacing,   GHWP_U16),
+    GHWP_FIELD (GHWPObject, instance_id, GHWP_U32),
+    GHWP_FIELD (GHWPObject, page_split,  GHWP_I32),
+    GHWP_FIELD (GHWPObject, n_desc,      GHWP_U16),
+};
+
 void ghwp_parse_common_object (GHWPObject *obj, GHWPContext *ctx)
 {
     /* must be called after reading ctrl id */
-    context_read_uint32 (ctx, &obj->attr);
-    context_read_hwp_unit (ctx, &obj->v_offset);
-    context_read_hwp_unit (ctx, &obj->h_offset);
-    context_read_hwp_unit (ctx, &obj->width);
-    context_read_hwp_unit (ctx, &obj->height);
-    context_read_int32 (ctx, &obj->z_order);
-    context_read_hwp_unit16 (ctx, &obj->l_spacing);
-    context_read_hwp_unit16 (ctx, &obj->r_spacing);
-    context_read_hwp_unit16 (ctx, &obj->t_spacing);
-    context_read_hwp_unit16 (ctx, &obj->b_spacing);
-    context_read_uint32 (ctx, &obj->instance_id);
-    context_read_int32 (ctx, &obj->page_split);
-    context_read_uint16 (ctx, &obj->n_desc);
+    context_decode (ctx, common_object_fields,
+                    G_N_ELEMENTS (common_object_fields), obj);
 
     gunichar2 ch; /* guint16 */
     GString  *text = g_string_new ("");
@@ -64,32 +74,43 @@ void ghwp_parse_common_object (GHWPObject *obj, GHWPContext *ctx)
     obj->desc = g_string_free (text, FALSE);
 }
 
+/* 문단 리스트 헤더 */
+static const GHWPField list_header_fields[] = {
+    GHWP_FIELD (GHWPListHeader, n_paragraphs, GHWP_I16),
+    GHWP_FIELD (GHWPListHeader, attr,         GHWP_U32),
+    GHWP_FIELD (GHWPListHeader, unknown,      GHWP_I16),
+};
+
 void ghwp_parse_list_header (GHWPListHeader *hdr, GHWPContext *ctx)
 {
     g_return_if_fail (ctx != NULL);
 
-    context_read_int16 (ctx, &hdr->n_paragraphs);
-    context_read_uint32 (ctx, &hdr->attr);
-    context_read_int16 (ctx, &hdr->unknown);
-}
+    context_decode (ctx, list_header_fields,
+                    G_N_ELEMENTS (list_header_fields), hdr);
+}
+
+/* 개체 요소 속성 */
+static const GHWPField shape_component_fields[] = {
+    GHWP_FIELD (GHWPComponent, ctrl_id,        GHWP_U32),
+    GHWP_FIELD (GHWPComponent, x_offset,       GHWP_I32),
+    GHWP_FIELD (GHWPComponent, y_offset,       GHWP_I32),
+    GHWP_FIELD (GHWPComponent, n_groups,       GHWP_U16),
+    GHWP_FIELD (GHWPComponent, local_version,  GHWP_U16),
+    GHWP_FIELD (GHWPComponent, initial_width,  GHWP_U32),
+    GHWP_FIELD (GHWPComponent, initial_height, GHWP_U32),
+    GHWP_FIELD (GHWPComponent, current_width,  GHWP_U32),
+    GHWP_FIELD (GHWPComponent, current_height, GHWP_U32),
+    GHWP_FIELD (GHWPComponent, attr,           GHWP_U32),
+    GHWP_FIELD (GHWPComponent, angle,          GHWP_U16),
+    GHWP_FIELD (GHWPComponent, x_center,       GHWP_I32),
+    GHWP_FIELD (GHWPComponent, y_center,       GHWP_I32),
+    GHWP_FIELD (GHWPComponent, render.cnt,     GHWP_I16),
+};
 
 void ghwp_parse_shape_component (GHWPComponent *compo, GHWPContext *ctx)
 {
-    context_read_uint32 (ctx, &compo->ctrl_id);
-    context_read_int32 (ctx, &compo->x_offset);
-    context_read_int32 (ctx, &compo->y_offset);
-    context_read_uint16 (ctx, &compo->n_groups);
-    context_read_uint16 (ctx, &compo->local_version);
-    context_read_uint32 (ctx, &compo->initial_width);
-    context_read_uint32 (ctx, &compo->initial_height);
-    context_read_uint32 (ctx, &compo->current_width);
-    context_read_uint32 (ctx, &compo->current_height);
-    context_read_uint32 (ctx, &compo->attr);
-    context_read_hwp_unit16 (ctx, &compo->angle);
-    context_read_int32 (ctx, &compo->x_center);
-    context_read_int32 (ctx, &compo->y_center);
-
-    context_read_int16 (ctx, &compo->render.cnt);
+    context_decode (ctx, shape_component_fields,
+                    G_N_ELEMENTS (shape_component_fields), compo);
     /* TODO: parse rendering info (matrix) */
 }
 
@@ -112,38 +133,259 @@ enum ghwp_control_type ghwp_control_char_type[GHWP_NUM_CC] = {
 
 G_DEFINE_TYPE (GHWPText, ghwp_text, G_TYPE_OBJECT);
 
+struct _GHWPTextPrivate
+{
+    guint32       *controls;    /* 인라인, 확장 제어 문자의 buf 안 위치 */
+    guint          n_controls;
+    GHWPTextArena *arena;       /* NULL 이 아니면 buf 와 controls 를 가진다 */
+    GString       *builder;     /* ghwp_text_append () 로 모으는 중인 텍스트 */
+};
+
 GHWPText *ghwp_text_new (void)
 {
     return (GHWPText *) g_object_new (GHWP_TYPE_TEXT, NULL);
 }
 
+/**
+ * ghwp_text_append:
+ * @ghwp_text: a #GHWPText
+ * @text: UTF-8 text to append
+ *
+ * Appends @text to @ghwp_text. The text is collected in a #GString until
+ * ghwp_text_get_text() is called, so appending many pieces takes time
+ * proportional to the total length.
+ *
+ * Returns: @ghwp_text
+ */
 GHWPText *ghwp_text_append (GHWPText *ghwp_text, const gchar *text)
 {
-    g_return_val_if_fail (ghwp_text != NULL, NULL);
+    GHWPTextPrivate *priv;
+
+    g_return_val_if_fail (GHWP_IS_TEXT (ghwp_text), NULL);
+
+    priv = ghwp_text->priv;
+
+    if (priv->builder == NULL) {
+        const gchar *old = ghwp_text_get_text (ghwp_text);
+
+        priv->builder = g_string_new (old ? old : "");
+        _g_free0 (ghwp_text->text);
+    }
+
+    if (text)
+        g_string_append (priv->builder, text);
 
-    gchar *tmp;
-    tmp = g_strdup (ghwp_text->text);
-    g_free (ghwp_text->text);
-    ghwp_text->text = g_strconcat (tmp, text, NULL);
-    g_free (tmp);
     return ghwp_text;
 }
 
+static void ghwp_text_free_buf (GHWPText *ghwp_text)
+{
+    GHWPTextPrivate *priv = ghwp_text->priv;
+
+    if (priv->arena) {
+        _ghwp_text_arena_unref (priv->arena);
+        priv->arena      = NULL;
+        ghwp_text->buf   = NULL;
+        priv->controls   = NULL;
+    } else {
+        _g_free0 (ghwp_text->buf);
+        _g_free0 (priv->controls);
+    }
+    priv->n_controls = 0;
+}
+
+/*
+ * buf 의 소유권을 가져오고 제어 문자의 위치만 기록해 둔다.
+ * arena 가 있으면 buf 는 arena 에서 할당한 것이고 제어 문자의 위치도
+ * arena 에 둔다. UTF-8 텍스트는 필요할 때 만든다.
+ */
+void _ghwp_text_set_buf (GHWPText      *ghwp_text,
+                         gunichar2     *buf,
+                         guint          n_chars,
+                         GHWPTextArena *arena)
+{
+    GHWPTextPrivate *priv;
+    GArray          *controls;
+    gsize            size;
+
+    g_return_if_fail (GHWP_IS_TEXT (ghwp_text));
+
+    priv = ghwp_text->priv;
+
+    _g_free0 (ghwp_text->text);
+    ghwp_text_free_buf (ghwp_text);
+
+    ghwp_text->buf     = buf;
+    ghwp_text->n_chars = n_chars;
+    if (arena)
+        priv->arena = _ghwp_text_arena_ref (arena);
+
+    if (buf == NULL) {
+        ghwp_text->text = g_strdup ("");
+        return;
+    }
+
+    if (arena) {
+        controls = _ghwp_text_arena_get_scratch (arena);
+        g_array_set_size (controls, 0);
+    } else {
+        controls = g_array_new (FALSE, FALSE, sizeof (guint32));
+    }
+
+    _ghwp_utf16_scan_controls (buf, n_chars, controls);
+    priv->n_controls = controls->len;
+    size = priv->n_controls * sizeof (guint32);
+
+    if (arena) {
+        priv->controls = _ghwp_text_arena_alloc (arena, size);
+        if (size)
+            memcpy (priv->controls, controls->data, size);
+    } else {
+        /* 배열의 메모리를 그대로 가져온다 */
+        priv->controls = (guint32 *) g_array_free (controls, size == 0);
+    }
+}
+
+/**
+ * ghwp_text_get_text:
+ * @ghwp_text: a #GHWPText
+ *
+ * Returns the text as UTF-8, without the inline and extended controls.
+ * For HWP v5 documents the UTF-8 text is made on the first call and
+ * kept until @ghwp_text is freed.
+ *
+ * Returns: the text, owned by @ghwp_text
+ */
+const gchar *ghwp_text_get_text (GHWPText *ghwp_text)
+{
+    GString *str;
+
+    g_return_val_if_fail (GHWP_IS_TEXT (ghwp_text), NULL);
+
+    /* ghwp_text_append () 로 모으던 텍스트를 확정한다 */
+    if (ghwp_text->priv->builder) {
+        ghwp_text->text = g_string_free (ghwp_text->priv->builder, FALSE);
+        ghwp_text->priv->builder = NULL;
+    }
+
+    if (ghwp_text->text || ghwp_text->buf == NULL)
+        return ghwp_text->text;
+
+    str = g_string_sized_new (ghwp_text->n_chars * 3 + 1);
+    _ghwp_utf16_decode_text (str, ghwp_text->buf, ghwp_text->n_chars, NULL);
+
+    ghwp_text->text = g_string_free (str, FALSE);
+    return ghwp_text->text;
+}
+
+/**
+ * ghwp_text_iter_init:
+ * @iter: an uninitialized #GHWPTextIter
+ * @ghwp_text: a #GHWPText
+ * @start: the position in #GHWPText.buf to start from
+ * @end: the position in #GHWPText.buf to stop at
+ *
+ * Initializes @iter to iterate over the runs of characters in
+ * [@start, @end) of the UTF-16 buffer, leaving out the inline and
+ * extended controls. Char controls such as tabs and line breaks are
+ * part of the runs.
+ */
+void ghwp_text_iter_init (GHWPTextIter *iter,
+                          GHWPText     *ghwp_text,
+                          guint         start,
+                          guint         end)
+{
+    GHWPTextPrivate *priv;
+    guint            lo, hi;
+
+    g_return_if_fail (iter != NULL);
+    g_return_if_fail (GHWP_IS_TEXT (ghwp_text));
+
+    priv = ghwp_text->priv;
+
+    iter->text = ghwp_text;
+    iter->pos  = start;
+    iter->end  = MIN (end, (guint) ghwp_text->n_chars);
+
+    /* start 에 걸치거나 start 뒤에 있는 첫 제어 문자를 찾는다 */
+    lo = 0;
+    hi = priv->n_controls;
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+
+        if (priv->controls[mid] + 8 <= start)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    iter->control = lo;
+}
+
+/**
+ * ghwp_text_iter_next:
+ * @iter: a #GHWPTextIter
+ * @units: (out): return location for the first unit of the run
+ * @n_units: (out): return location for the number of units in the run
+ *
+ * Gets the next run of characters. The units point into #GHWPText.buf
+ * and are in host byte order; nothing is allocated.
+ *
+ * Returns: %FALSE if there are no more runs
+ */
+gboolean ghwp_text_iter_next (GHWPTextIter     *iter,
+                              const gunichar2 **units,
+                              guint            *n_units)
+{
+    GHWPTextPrivate *priv;
+    guint            stop;
+
+    g_return_val_if_fail (iter != NULL, FALSE);
+
+    priv = iter->text->priv;
+
+    while (iter->pos < iter->end) {
+        if (iter->control < priv->n_controls &&
+            priv->controls[iter->control] <= iter->pos) {
+            /* 인라인, 확장 제어 문자는 8 글자를 차지한다 */
+            iter->pos = priv->controls[iter->control] + 8;
+            iter->control++;
+            continue;
+        }
+
+        stop = iter->end;
+        if (iter->control < priv->n_controls)
+            stop = MIN (stop, priv->controls[iter->control]);
+
+        *units     = iter->text->buf + iter->pos;
+        *n_units   = stop - iter->pos;
+        iter->pos  = stop;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
 static void ghwp_text_finalize (GObject *obj)
 {
     GHWPText *ghwp_text = GHWP_TEXT(obj);
     _g_free0 (ghwp_text->text);
+    ghwp_text_free_buf (ghwp_text);
+    if (ghwp_text->priv->builder)
+        g_string_free (ghwp_text->priv->builder, TRUE);
     G_OBJECT_CLASS (ghwp_text_parent_class)->finalize (obj);
 }
 
 static void ghwp_text_class_init (GHWPTextClass *klass)
 {
     GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    g_type_class_add_private (klass, sizeof (GHWPTextPrivate));
     object_class->finalize     = ghwp_text_finalize;
 }
 
 static void ghwp_text_init (GHWPText *ghwp_text)
 {
+    ghwp_text->priv = G_TYPE_INSTANCE_GET_PRIVATE (ghwp_text, GHWP_TYPE_TEXT,
+                                                   GHWPTextPrivate);
 }
 
 /** GHWPPicture *****************************************************************/
@@ -176,31 +418,32 @@ static void ghwp_picture_init (GHWPPicture *pic)
     pic->stream = NULL;
 }
 
+/* 그림 개체 속성 */
+static const GHWPField picture_fields[] = {
+    GHWP_FIELD   (GHWPPicture, border_color,    GHWP_U32),
+    GHWP_FIELD   (GHWPPicture, border_width,    GHWP_U32),
+    GHWP_FIELD   (GHWPPicture, border_attr,     GHWP_U32),
+    GHWP_FIELD_N (GHWPPicture, border_x_pos, 4, GHWP_I32),
+    GHWP_FIELD_N (GHWPPicture, border_y_pos, 4, GHWP_I32),
+    GHWP_FIELD   (GHWPPicture, cropped_left,    GHWP_I32),
+    GHWP_FIELD   (GHWPPicture, cropped_top,     GHWP_I32),
+    GHWP_FIELD   (GHWPPicture, cropped_right,   GHWP_I32),
+    GHWP_FIELD   (GHWPPicture, cropped_bottom,  GHWP_I32),
+    GHWP_FIELD   (GHWPPicture, l_margin,        GHWP_U16),
+    GHWP_FIELD   (GHWPPicture, r_margin,        GHWP_U16),
+    GHWP_FIELD   (GHWPPicture, t_margin,        GHWP_U16),
+    GHWP_FIELD   (GHWPPicture, b_margin,        GHWP_U16),
+    GHWP_FIELD   (GHWPPicture, brightness,      GHWP_I8),
+    GHWP_FIELD   (GHWPPicture, contrast,        GHWP_I8),
+    GHWP_FIELD   (GHWPPicture, effect,          GHWP_U8),
+    GHWP_FIELD   (GHWPPicture, binitem_id,      GHWP_U16),
+    GHWP_FIELD   (GHWPPicture, border_trans,    GHWP_U8),
+    GHWP_FIELD   (GHWPPicture, instance_id,     GHWP_U32),
+};
+
 void ghwp_parse_picture (GHWPPicture *pic, GHWPContext *ctx)
 {
-    gint i;
-
-    context_read_uint32 (ctx, &pic->border_color);
-    context_read_uint32 (ctx, &pic->border_width);
-    context_read_uint32 (ctx, &pic->border_attr);
-    for (i = 0; i < 4; i++)
-        context_read_int32 (ctx, &pic->border_x_pos[i]);
-    for (i = 0; i < 4; i++)
-        context_read_int32 (ctx, &pic->border_y_pos[i]);
-    context_read_int32 (ctx, &pic->cropped_left);
-    context_read_int32 (ctx, &pic->cropped_top);
-    context_read_int32 (ctx, &pic->cropped_right);
-    context_read_int32 (ctx, &pic->cropped_bottom);
-    context_read_hwp_unit16 (ctx, &pic->l_margin);
-    context_read_hwp_unit16 (ctx, &pic->r_margin);
-    context_read_hwp_unit16 (ctx, &pic->t_margin);
-    context_read_hwp_unit16 (ctx, &pic->b_margin);
-    context_read_int8 (ctx, &pic->brightness);
-    context_read_int8 (ctx, &pic->contrast);
-    context_read_uint8 (ctx, &pic->effect);
-    context_read_uint16 (ctx, &pic->binitem_id);
-    context_read_uint8 (ctx, &pic->border_trans);
-    context_read_uint32 (ctx, &pic->instance_id);
+    context_decode (ctx, picture_fields, G_N_ELEMENTS (picture_fields), pic);
 }
 
 void ghwp_picture_set_gso (GHWPPicture *pic, GHWPGSO *gso)
@@ -340,24 +583,35 @@ GHWPPicture *ghwp_paragraph_get_picture (GHWPParagraph *paragraph)
     return paragraph->picture;
 }
 
+/* 문단 헤더 */
+static const GHWPField paragraph_header_fields[] = {
+    GHWP_FIELD (GHWPParagraphHeader, n_chars,       GHWP_U32),
+    GHWP_FIELD (GHWPParagraphHeader, control_mask,  GHWP_U32),
+    GHWP_FIELD (GHWPParagraphHeader, para_shape_id, GHWP_U16),
+    GHWP_FIELD (GHWPParagraphHeader, para_style_id, GHWP_U8),
+    GHWP_FIELD (GHWPParagraphHeader, col_split,     GHWP_U8),
+    GHWP_FIELD (GHWPParagraphHeader, n_char_shapes, GHWP_U16),
+    GHWP_FIELD (GHWPParagraphHeader, n_range_tags,  GHWP_U16),
+    GHWP_FIELD (GHWPParagraphHeader, n_line_segs,   GHWP_U16),
+    GHWP_FIELD (GHWPParagraphHeader, para_id,       GHWP_U32),
+    GHWP_FIELD_SINCE (GHWPParagraphHeader, history_merge, GHWP_U16, 5, 0, 3, 2),
+};
+
+void ghwp_parse_paragraph_header_data (GHWPParagraphHeader *header,
+                                       GHWPContext         *ctx)
+{
+    g_return_if_fail (header != NULL);
+
+    context_decode (ctx, paragraph_header_fields,
+                    G_N_ELEMENTS (paragraph_header_fields), header);
+}
+
 void ghwp_parse_paragraph_header (GHWPParagraph *paragraph,
                                   GHWPContext *ctx)
 {
     g_return_if_fail (paragraph != NULL);
 
-    context_read_uint32 (ctx, &paragraph->header.n_chars);
-    context_read_uint32 (ctx, &paragraph->header.control_mask);
-    context_read_uint16 (ctx, &paragraph->header.para_shape_id);
-    context_read_uint8  (ctx, &paragraph->header.para_style_id);
-    context_read_uint8  (ctx, &paragraph->header.col_split);
-    context_read_uint16 (ctx, &paragraph->header.n_char_shapes);
-    context_read_uint16 (ctx, &paragraph->header.n_range_tags);
-    context_read_uint16 (ctx, &paragraph->header.n_line_segs);
-    context_read_uint32 (ctx, &paragraph->header.para_id);
-
-    if (context_check_version(ctx, 5, 0, 3, 2)) {
-        context_read_uint16 (ctx, &paragraph->header.history_merge);
-    }
+    ghwp_parse_paragraph_header_data (&paragraph->header, ctx);
 
     paragraph->char_shapes = g_array_sized_new (TRUE, TRUE, sizeof (GHWPCharShapeRef *),
                                                 paragraph->header.n_char_shapes);
@@ -371,49 +625,70 @@ void ghwp_parse_paragraph_header (GHWPParagraph *paragraph,
 }
 
 void ghwp_parse_paragraph_text (GHWPParagraph *paragraph,
-                                GHWPContext *ctx)
+                                GHWPContext   *ctx,
+                                GHWPTextArena *arena)
 {
-    guint i;
-    GHWPText *ghwp_text;
-    GString  *str = g_string_new("");
+    GHWPText     *ghwp_text;
+    const guint8 *data;
+    gunichar2    *buf = NULL;
+    guint         n_chars;
+    guint         i G_GNUC_UNUSED;
 
     g_return_if_fail (paragraph != NULL);
 
-    ghwp_text = ghwp_text_new ();
-    ghwp_text->buf = g_malloc0(ctx->data_len);
-    ghwp_text->n_chars = ctx->data_len / 2;
+    n_chars = ctx->data_len / 2;
+
+    /* 레코드 데이터를 한 번에 복사한다. arena 가 있으면 섹션의
+     * 다른 문단들과 같은 블록에 둔다. */
+    data = context_read_ptr (ctx, n_chars * 2);
+    if (data == NULL)
+        n_chars = 0;
+
+    if (n_chars > 0) {
+        if (arena)
+            buf = _ghwp_text_arena_alloc (arena, n_chars * 2);
+        else
+            buf = g_malloc (n_chars * 2);
+        memcpy (buf, data, n_chars * 2);
+    }
 
-    for (i = 0; i < ghwp_text->n_chars; i++) {
-        context_read_uint16 (ctx, &ghwp_text->buf[i]);
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    for (i = 0; i < n_chars; i++) {
+        buf[i] = GUINT16_FROM_LE(buf[i]);
     }
+#endif
 
-    for (i = 0; i < ghwp_text->n_chars; i++) {
-        gunichar2 ch = ghwp_text->buf[i];
+    /* UTF-8 텍스트는 만들지 않고 제어 문자의 위치만 기록한다 */
+    ghwp_text = ghwp_text_new ();
+    _ghwp_text_set_buf (ghwp_text, buf, n_chars, arena);
 
-        if (ch < GHWP_NUM_CC) {
-            if (ghwp_control_char_type[ch] != GHWP_CC_TYPE_CHAR) {
-                struct ghwp_control *cc = (void *)&ghwp_text->buf[i];
+#ifdef GHWP_DEBUG
+    for (i = 0; i < ghwp_text->priv->n_controls; i++) {
+        guint pos = ghwp_text->priv->controls[i];
+        struct ghwp_control *cc = (void *)&ghwp_text->buf[pos];
 
-                dbg ("%*s char: "CTRL_ID_FMT"\n", ctx->level * 3, "",
-                     CTRL_ID_PRINT (cc->id));
+        if (pos + 8 > n_chars)
+            continue;
 
-                if (cc->code1 != cc->code2) {
-                    dbg ("%*s control char mismatch: pos %u (%d != %#hx)\n",
-                         ctx->level * 3, "", i, cc->code1, cc->code2);
-                }
+        dbg ("%*s char: "CTRL_ID_FMT"\n", ctx->level * 3, "",
+             CTRL_ID_PRINT (cc->id));
 
-                i += 7;
-                continue;
-            }
+        if (cc->code1 != cc->code2) {
+            dbg ("%*s control char mismatch: pos %u (%d != %#hx)\n",
+                 ctx->level * 3, "", pos, cc->code1, cc->code2);
         }
-
-        g_string_append_unichar(str, ch);
     }
-    ghwp_text->text = g_string_free (str, FALSE);
+#endif
 
     ghwp_paragraph_set_ghwp_text(paragraph, ghwp_text);
 }
 
+/* 문단의 글자 모양 */
+static const GHWPField char_shape_ref_fields[] = {
+    GHWP_FIELD (GHWPCharShapeRef, pos, GHWP_U32),
+    GHWP_FIELD (GHWPCharShapeRef, id,  GHWP_U32),
+};
+
 void ghwp_parse_paragraph_char_shape (GHWPParagraph *paragraph,
                                       GHWPContext *ctx)
 {
@@ -424,13 +699,26 @@ void ghwp_parse_paragraph_char_shape (GHWPParagraph *paragraph,
     for (i = 0; i < paragraph->header.n_char_shapes; i++) {
         GHWPCharShapeRef *char_shape = malloc (sizeof (*char_shape));
 
-        context_read_uint32 (ctx, &char_shape->pos);
-        context_read_uint32 (ctx, &char_shape->id);
+        context_decode (ctx, char_shape_ref_fields,
+                        G_N_ELEMENTS (char_shape_ref_fields), char_shape);
 
         g_array_insert_val (paragraph->char_shapes, i, char_shape);
     }
 }
 
+/* 문단의 레이아웃 */
+static const GHWPField line_seg_fields[] = {
+    GHWP_FIELD (GHWPLineSeg, text_start,    GHWP_U32),
+    GHWP_FIELD (GHWPLineSeg, v_pos,         GHWP_I32),
+    GHWP_FIELD (GHWPLineSeg, line_height,   GHWP_I32),
+    GHWP_FIELD (GHWPLineSeg, text_height,   GHWP_I32),
+    GHWP_FIELD (GHWPLineSeg, base_line,     GHWP_I32),
+    GHWP_FIELD (GHWPLineSeg, line_spacing,  GHWP_I32),
+    GHWP_FIELD (GHWPLineSeg, col_offset,    GHWP_I32),
+    GHWP_FIELD (GHWPLineSeg, segment_width, GHWP_I32),
+    GHWP_FIELD (GHWPLineSeg, tag,           GHWP_U32),
+};
+
 void ghwp_parse_paragraph_line_seg (GHWPParagraph *paragraph,
                                     GHWPContext *ctx)
 {
@@ -441,20 +729,20 @@ void ghwp_parse_paragraph_line_seg (GHWPParagraph *paragraph,
     for (i = 0; i < paragraph->header.n_line_segs; i++) {
         GHWPLineSeg *line_seg = malloc (sizeof (*line_seg));
 
-        context_read_uint32 (ctx, &line_seg->text_start);
-        context_read_int32  (ctx, &line_seg->v_pos);
-        context_read_int32  (ctx, &line_seg->line_height);
-        context_read_int32  (ctx, &line_seg->text_height);
-        context_read_int32  (ctx, &line_seg->base_line);
-        context_read_int32  (ctx, &line_seg->line_spacing);
-        context_read_int32  (ctx, &line_seg->col_offset);
-        context_read_int32  (ctx, &line_seg->segment_width);
-        context_read_uint32 (ctx, &line_seg->tag);
+        context_decode (ctx, line_seg_fields,
+                        G_N_ELEMENTS (line_seg_fields), line_seg);
 
         g_array_insert_val (paragraph->line_segs, i, line_seg);
     }
 }
 
+/* 문단의 영역 태그 */
+static const GHWPField range_tag_fields[] = {
+    GHWP_FIELD (GHWPRangeTag, start, GHWP_U32),
+    GHWP_FIELD (GHWPRangeTag, end,   GHWP_U32),
+    GHWP_FIELD (GHWPRangeTag, tag,   GHWP_U32),
+};
+
 void ghwp_parse_paragraph_range_tag (GHWPParagraph *paragraph,
                                      GHWPContext *ctx)
 {
@@ -465,9 +753,8 @@ void ghwp_parse_paragraph_range_tag (GHWPParagraph *paragraph,
     for (i = 0; i < paragraph->header.n_char_shapes; i++) {
         GHWPRangeTag *range_tag = malloc (sizeof (*range_tag));
 
-        context_read_uint32 (ctx, &range_tag->start);
-        context_read_uint32 (ctx, &range_tag->end);
-        context_read_uint32 (ctx, &range_tag->tag);
+        context_decode (ctx, range_tag_fields,
+                        G_N_ELEMENTS (range_tag_fields), range_tag);
 
         g_array_insert_val (paragraph->range_tags, i, range_tag);
     }
@@ -484,11 +771,11 @@ GHWPTable *ghwp_table_new (void)
 
 #include <stdio.h>
 
-void hexdump(guint8 *data, guint16 data_len)
+void hexdump(guint8 *data, guint32 data_len)
 {
-    int i = 0;
+    guint32 i = 0;
 
-    printf("data_len = %d\n", data_len);
+    printf("data_len = %u\n", data_len);
     printf("-----------------------------------------------\n");
     printf("00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15\n");
     printf("-----------------------------------------------\n");
@@ -501,19 +788,24 @@ void hexdump(guint8 *data, guint16 data_len)
     printf("\n-----------------------------------------------\n");
 }
 
+/* 표 개체 속성 */
+static const GHWPField table_fields[] = {
+    GHWP_FIELD (GHWPTable, flags,        GHWP_U32),
+    GHWP_FIELD (GHWPTable, n_rows,       GHWP_U16),
+    GHWP_FIELD (GHWPTable, n_cols,       GHWP_U16),
+    GHWP_FIELD (GHWPTable, cell_spacing, GHWP_U16),
+    GHWP_FIELD (GHWPTable, l_margin,     GHWP_U16),
+    GHWP_FIELD (GHWPTable, r_margin,     GHWP_U16),
+    GHWP_FIELD (GHWPTable, t_margin,     GHWP_U16),
+    GHWP_FIELD (GHWPTable, b_margin,     GHWP_U16),
+};
+
 void ghwp_parse_table_attr (GHWPTable *table, GHWPContext *context)
 {
     g_return_if_fail (context != NULL);
     int        i;
 
-    context_read_uint32 (context, &table->flags);
-    context_read_uint16 (context, &table->n_rows);
-    context_read_uint16 (context, &table->n_cols);
-    context_read_hwp_unit16 (context, &table->cell_spacing);
-    context_read_hwp_unit16 (context, &table->l_margin);
-    context_read_hwp_unit16 (context, &table->r_margin);
-    context_read_hwp_unit16 (context, &table->t_margin);
-    context_read_hwp_unit16 (context, &table->b_margin);
+    context_decode (context, table_fields, G_N_ELEMENTS (table_fields), table);
 
     table->row_sizes = g_malloc0_n (table->n_rows, 2);
 
@@ -605,30 +897,28 @@ GHWPTableCell *ghwp_table_cell_new (void)
     return (GHWPTableCell *) g_object_new (GHWP_TYPE_TABLE_CELL, NULL);
 }
 
+/* 표 75 셀 속성 */
+static const GHWPField table_cell_fields[] = {
+    GHWP_FIELD (GHWPTableCell, col_addr,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, row_addr,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, col_span,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, row_span,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, width,          GHWP_U32),
+    GHWP_FIELD (GHWPTableCell, height,         GHWP_U32),
+    GHWP_FIELD (GHWPTableCell, l_margin,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, r_margin,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, t_margin,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, b_margin,       GHWP_U16),
+    GHWP_FIELD (GHWPTableCell, border_fill_id, GHWP_U16),
+};
+
 GHWPTableCell *ghwp_parse_table_cell_attr (GHWPTableCell *table_cell,
                                            GHWPContext *context)
 {
     g_return_val_if_fail (context != NULL, NULL);
 
-    /* 표 75 */
-    context_read_uint16 (context, &table_cell->col_addr);
-    context_read_uint16 (context, &table_cell->row_addr);
-    context_read_uint16 (context, &table_cell->col_span);
-    context_read_uint16 (context, &table_cell->row_span);
-
-    context_read_hwp_unit (context, &table_cell->width);
-    context_read_hwp_unit (context, &table_cell->height);
-
-    context_read_hwp_unit16 (context, &table_cell->l_margin);
-    context_read_hwp_unit16 (context, &table_cell->r_margin);
-    context_read_hwp_unit16 (context, &table_cell->t_margin);
-    context_read_hwp_unit16 (context, &table_cell->b_margin);
-
-    context_read_uint16 (context, &table_cell->border_fill_id);
-
-    if (context->data_count != context->data_len) {
-        //g_printf ("%s:%d: table cell size mismatch\n", __FILE__, __LINE__);
-    }
+    context_decode (context, table_cell_fields,
+                    G_N_ELEMENTS (table_cell_fields), table_cell);
     return table_cell;
 }
 
@@ -275,10 +275,13 @@ void           ghwp_paragraph_set_picture       (GHWPParagraph *paragraph,
 void           ghwp_paragraph_add_link          (GHWPParagraph *paragraph,
                                                  GHWPParagraph *link,
                                                  gint           line);
+void           ghwp_parse_paragraph_header_data (GHWPParagraphHeader *header,
+                                                 GHWPContext *ctx);
 void           ghwp_parse_paragraph_header      (GHWPParagraph *paragraph,
                                                  GHWPContext *ctx);
 void           ghwp_parse_paragraph_text        (GHWPParagraph *paragraph,
-                                                 GHWPContext *ctx);
+                                                 GHWPContext *ctx,
+                                                 struct _GHWPTextArena *arena);
 void           ghwp_parse_paragraph_char_shape  (GHWPParagraph *paragraph,
                                                  GHWPContext *ctx);
 void           ghwp_parse_paragraph_line_seg    (GHWPParagraph *paragraph,
@@ -366,11 +369,25 @@ struct ghwp_control {
     gunichar2       code2;
 } __attribute__((packed));
 
+/*
+ * v5 문서는 buf (PARA_TEXT 의 UTF-16, 제어 문자 포함) 만 가지고 있고
+ * text 는 ghwp_text_get_text () 를 처음 부를 때 만든다.
+ * v3, HWPML 문서는 buf 가 NULL 이고 text 만 가지고 있다.
+ */
+
+/**
+ * GHWPText:
+ * @text: private cache of the UTF-8 text, %NULL until
+ *     ghwp_text_get_text() is called for a v5 document. Deprecated for
+ *     direct access; use ghwp_text_get_text().
+ * @buf: the UTF-16 text of a v5 paragraph, including control characters
+ * @n_chars: the number of UTF-16 units in @buf
+ */
 struct _GHWPText
 {
     GObject          parent_instance;
     GHWPTextPrivate *priv;
-    gchar           *text;
+    gchar           *text;      /* private: ghwp_text_get_text () 를 쓴다 */
     gunichar2       *buf;
     gint             n_chars;
 };
@@ -380,9 +397,27 @@ struct _GHWPTextClass
     GObjectClass parent_class;
 };
 
-GType     ghwp_text_get_type (void) G_GNUC_CONST;
-GHWPText *ghwp_text_new      (void);
-GHWPText *ghwp_text_append   (GHWPText *ghwp_text, const gchar *text);
+/* buf 에서 제어 문자를 뺀 글자들을 차례로 돌려준다 */
+typedef struct
+{
+    GHWPText *text;
+    guint     pos;
+    guint     end;
+    guint     control;
+} GHWPTextIter;
+
+GType        ghwp_text_get_type  (void) G_GNUC_CONST;
+GHWPText    *ghwp_text_new       (void);
+GHWPText    *ghwp_text_append    (GHWPText        *ghwp_text,
+                                  const gchar     *text);
+const gchar *ghwp_text_get_text  (GHWPText        *ghwp_text);
+void         ghwp_text_iter_init (GHWPTextIter    *iter,
+                                  GHWPText        *ghwp_text,
+                                  guint            start,
+                                  guint            end);
+gboolean     ghwp_text_iter_next (GHWPTextIter    *iter,
+                                  const gunichar2 **units,
+                                  guint           *n_units);
 
 /** GHWPPicture *****************************************************************/
 
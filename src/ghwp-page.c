@@ -20,6 +20,8 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include "ghwp-page.h"
+#include "ghwp-private.h"
+#include "ghwp-utf16.h"
 
 extern void gdk_cairo_set_source_pixbuf (cairo_t *cr,
                                          const GdkPixbuf *pixbuf,
@@ -145,7 +147,8 @@ once_ft_init_and_new (GHWPDocument *doc, cairo_t *cr)
 }
 
 static void draw_picture (cairo_t *cr, GHWPPicture *pic, GHWPParagraph *paragraph,
-                          GHWPPageDef *page_info, double para_x, double para_y)
+                          GHWPPageDef *page_info, double para_x, double para_y,
+                          GCancellable *cancellable)
 {
     GHWPGSO *gso = pic->gso;
     gdouble  x = 0;
@@ -161,7 +164,11 @@ static void draw_picture (cairo_t *cr, GHWPPicture *pic, GHWPParagraph *paragrap
         pic->pixbuf = gdk_pixbuf_new_from_stream_at_scale (pic->stream,
                                            gso->component.current_width / GHWP_UPP,
                                            gso->component.current_height / GHWP_UPP,
-                                           TRUE, NULL, &error);
+                                           TRUE, cancellable, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_clear_error (&error);
+            return;
+        }
         if (error != NULL) {
             g_warning ("Error: %s\n", error->message);
             g_clear_error (&error);
@@ -207,39 +214,32 @@ static gdouble draw_text_line (cairo_t             *cr,
                                double               y,
                                GHWPText            *text,
                                gint                 start,
-                               gint                 end)
+                               gint                 end,
+                               GString             *strbuf)
 {
-    gchar *str;
     int    num_glyphs;
     cairo_glyph_t *glyphs = NULL; /* NULL로 지정하면 자동 할당됨 */
     cairo_text_extents_t extents;
-    GString  *strbuf = g_string_new ("");
-    gunichar2 ch;
-    gint i;
+    GHWPTextIter     iter;
+    const gunichar2 *units;
+    guint            n_units;
 
     if (start >= end)
         return x;
 
-    for (i = start; i < end; i++) {
-        ch = text->buf[i];
-
-        if (ch >= GHWP_NUM_CC || ghwp_control_char_type[ch] == GHWP_CC_TYPE_CHAR) {
-            g_string_append_unichar (strbuf, ch);
-            continue;
-        }
+    /* TODO: handle control characters if needed */
+    g_string_truncate (strbuf, 0);
+    ghwp_text_iter_init (&iter, text, start, end);
+    while (ghwp_text_iter_next (&iter, &units, &n_units))
+        _ghwp_utf16_append_utf8 (strbuf, units, n_units);
 
-        /* TODO: handle control characters if needed */
-        i += 7;
-    }
-    str = g_string_free (strbuf, FALSE);
-
-    cairo_scaled_font_text_to_glyphs (font, x / GHWP_UPP, y / GHWP_UPP, str, -1,
+    cairo_scaled_font_text_to_glyphs (font, x / GHWP_UPP, y / GHWP_UPP,
+                                      strbuf->str, strbuf->len,
                                       &glyphs, &num_glyphs, NULL, NULL, NULL);
     cairo_show_glyphs (cr, glyphs, num_glyphs);
     cairo_glyph_extents (cr, glyphs, num_glyphs, &extents);
 
     cairo_glyph_free (glyphs);
-    _g_free0 (str);
 
     return x + extents.x_advance * GHWP_UPP;
 }
@@ -252,6 +252,10 @@ static void draw_paragraph_texts (cairo_t       *cr,
 {
     gint      i, k = 0;
     GHWPText *ghwp_text = paragraph->ghwp_text;
+    GString  *strbuf;
+
+    /* 줄마다 UTF-8 로 바꿀 버퍼를 함께 쓴다 */
+    strbuf = g_string_sized_new (256);
 
     for (i = paragraph->line_start; i < paragraph->line_end; i++) {
         GHWPLineSeg *line = NULL;
@@ -305,11 +309,13 @@ static void draw_paragraph_texts (cairo_t       *cr,
                                   GHWP_COLOR_B(shape->char_color));
 
             x = draw_text_line(cr, font, x + line->col_offset, y + line->v_pos,
-                               ghwp_text, shape_start, shape_end);
+                               ghwp_text, shape_start, shape_end, strbuf);
 
             shape_start = shape_end;
         } while (shape_end < text_end);
     }
+
+    g_string_free (strbuf, TRUE);
 }
 
 gboolean ghwp_page_render (GHWPPage *page, cairo_t *cr)
@@ -340,7 +346,10 @@ gboolean ghwp_page_render (GHWPPage *page, cairo_t *cr)
         ghwp_text = paragraph->ghwp_text;
 
         /* draw text */
-        if ((ghwp_text != NULL) && !(g_str_equal(ghwp_text->text, "\n\r"))) {
+        /* v5 문서의 텍스트는 UTF-8 로 바꾸지 않고 그린다 */
+        if ((ghwp_text != NULL) &&
+            (ghwp_text->buf != NULL ||
+             !g_str_equal (ghwp_text_get_text (ghwp_text), "\n\r"))) {
             draw_paragraph_texts (cr, page->section->document, paragraph,
                                   page_info->l_margin,
                                   page_info->t_margin + page_info->header);
@@ -400,7 +409,8 @@ gboolean ghwp_page_render (GHWPPage *page, cairo_t *cr)
             x = page_info->l_margin;
             y = page_info->t_margin + page_info->header + line->v_pos;
 
-            draw_picture (cr, pic, paragraph, page_info, x, y);
+            draw_picture (cr, pic, paragraph, page_info, x, y,
+                _ghwp_file_get_cancellable (page->section->document->file));
         }
     }
 
@@ -22,9 +22,11 @@
 #include <glib-object.h>
 #include <glib/gi18n-lib.h>
 #include <gio/gio.h>
+#include <string.h>
 
 #include "ghwp.h"
 #include "ghwp-parse.h"
+#include "ghwp-private.h"
 
 G_DEFINE_TYPE (GHWPContext, ghwp_context, G_TYPE_OBJECT);
 
@@ -35,22 +37,101 @@ G_DEFINE_TYPE (GHWPContext, ghwp_context, G_TYPE_OBJECT);
 
 static void ghwp_context_finalize (GObject* obj);
 
-gboolean context_skip (GHWPContext *context, guint16 count)
+/* 스트림에 남은 것보다 긴 레코드는 버퍼를 잡거나 건너뛰기 전에 거른다.
+ * 남은 크기를 알 수 없는 (압축을 푸는) 스트림이면 섹션의 최대 크기로
+ * 제한한다. */
+static gboolean context_check_data_len (GHWPContext *context, GError **error)
 {
-    g_return_val_if_fail (context != NULL, FALSE);
+    guint64 remaining = GHWP_SECTION_MAX_SIZE;
 
-    gboolean is_success = FALSE;
-    guint8  *buf        = g_malloc (count);
-    /* FIXME g_input_stream_skip 가 작동하지 않아 아래처럼 처리했다. */
-    is_success = g_input_stream_read_all (context->stream, buf, (gsize) count,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    g_free (buf);
+    if (GSF_IS_INPUT_STREAM (context->stream)) {
+        GsfInputStream *gis  = GSF_INPUT_STREAM (context->stream);
+        gssize          size = gsf_input_stream_size (gis);
+        goffset         pos  = g_seekable_tell (G_SEEKABLE (gis));
+
+        remaining = size > pos ? (guint64) (size - pos) : 0;
+    }
+
+    if ((guint64) context->data_len > remaining) {
+        g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                             _("File corrupted"));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* 스트림에서 읽을 때, 레코드 데이터는 처음 값을 꺼낼 때 한 번에 버퍼로
+ * 읽는다. 한 번도 읽지 않은 레코드는 ghwp_context_pull 에서 건너뛰므로
+ * 파싱하지 않는 레코드는 복사하지 않는다. 읽다가 난 에러는 다음
+ * ghwp_context_pull 에서 보고한다. */
+static gboolean context_load (GHWPContext *context)
+{
+    GHWPContextPrivate *priv = context->priv;
+    gboolean is_success;
+
+    if (priv->error)
+        return FALSE;
+
+    /* 압축되지 않은 GsfInput 스트림이면 복사하지 않고 빌려 쓴다 */
+    if (GSF_IS_INPUT_STREAM (context->stream)) {
+        if (g_cancellable_set_error_if_cancelled (priv->cancellable,
+                                                  &priv->error))
+            return FALSE;
+
+        priv->data = gsf_input_stream_borrow (GSF_INPUT_STREAM (context->stream),
+                                              (gsize) context->data_len);
+        if (priv->data == NULL) {
+            g_set_error_literal (&priv->error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                                 _("File corrupted"));
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    if (!context_check_data_len (context, &priv->error))
+        return FALSE;
+
+    if (context->data_len > priv->buf_size) {
+        priv->buf      = g_realloc (priv->buf, context->data_len);
+        priv->buf_size = context->data_len;
+    }
 
-    if ((is_success == FALSE) || (context->priv->bytes_read != (gsize) count))
-    {
+    is_success = g_input_stream_read_all (context->stream, priv->buf,
+                                          (gsize) context->data_len,
+                                          &priv->bytes_read,
+                                          priv->cancellable, &priv->error);
+    if (is_success == FALSE)
+        return FALSE;
+
+    /* 비정상 */
+    if (priv->bytes_read != (gsize) context->data_len) {
+        g_set_error_literal (&priv->error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                             _("File corrupted"));
+        return FALSE;
+    }
+
+    priv->data = priv->buf;
+    return TRUE;
+}
+
+static inline gboolean
+context_read_data (GHWPContext *context, void *dest, guint32 size)
+{
+    if (G_UNLIKELY (context->priv->data == NULL) && !context_load (context))
+        return FALSE;
+
+    memcpy (dest, context->priv->data + context->data_count, size);
+    context->data_count += size;
+    return TRUE;
+}
+
+gboolean context_skip (GHWPContext *context, guint32 count)
+{
+    g_return_val_if_fail (context != NULL, FALSE);
+
+    if (count > context->data_len - context->data_count) {
         g_warning ("%s:%d:skip size mismatch\n", __FILE__, __LINE__);
-        g_input_stream_close (context->stream, NULL, NULL);
         return FALSE;
     }
 
@@ -61,190 +142,310 @@ gboolean context_skip (GHWPContext *context, guint16 count)
 gboolean context_read_int8 (GHWPContext *context, gint8 *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 1, FALSE);
+    g_return_val_if_fail (context->data_count + 1 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 1,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 1))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 1))
         return FALSE;
-    }
-    context->data_count += 1;
     return TRUE;
 }
 
 gboolean context_read_int16 (GHWPContext *context, gint16 *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 2, FALSE);
+    g_return_val_if_fail (context->data_count + 2 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 2,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 2))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 2))
         return FALSE;
-    }
     *i = GINT16_FROM_LE(*i);
-    context->data_count += 2;
     return TRUE;
 }
 
 gboolean context_read_int32 (GHWPContext *context, gint32 *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 4, FALSE);
+    g_return_val_if_fail (context->data_count + 4 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 4,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 4))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 4))
         return FALSE;
-    }
     *i = GINT32_FROM_LE(*i);
-    context->data_count += 4;
     return TRUE;
 }
 
 gboolean context_read_uint8 (GHWPContext *context, guint8 *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 1, FALSE);
+    g_return_val_if_fail (context->data_count + 1 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 1,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 1))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 1))
         return FALSE;
-    }
-    context->data_count += 1;
     return TRUE;
 }
 
 gboolean context_read_uint16 (GHWPContext *context, guint16 *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 2, FALSE);
+    g_return_val_if_fail (context->data_count + 2 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 2,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 2))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 2))
         return FALSE;
-    }
     *i = GUINT16_FROM_LE(*i);
-    context->data_count += 2;
     return TRUE;
 }
 
 gboolean context_read_uint32 (GHWPContext *context, guint32 *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 4, FALSE);
+    g_return_val_if_fail (context->data_count + 4 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 4,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 4))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 4))
         return FALSE;
-    }
     *i = GUINT32_FROM_LE(*i);
-    context->data_count += 4;
     return TRUE;
 }
 
 gboolean context_read_hwp_unit16 (GHWPContext *context, ghwp_unit16 *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 2, FALSE);
+    g_return_val_if_fail (context->data_count + 2 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 2,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 2))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 2))
         return FALSE;
-    }
     *i = GUINT16_FROM_LE(*i);
-    context->data_count += 2;
     return TRUE;
 }
 
 gboolean context_read_hwp_unit (GHWPContext *context, ghwp_unit *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 4, FALSE);
+    g_return_val_if_fail (context->data_count + 4 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 4,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 4))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 4))
         return FALSE;
-    }
     *i = GUINT32_FROM_LE(*i);
-    context->data_count += 4;
     return TRUE;
 }
 
 gboolean context_read_hwp_color (GHWPContext *context, ghwp_color *i)
 {
     g_return_val_if_fail (context != NULL, FALSE);
-    g_return_val_if_fail (context->data_count <= context->data_len - 4, FALSE);
+    g_return_val_if_fail (context->data_count + 4 <= context->data_len, FALSE);
 
-    gboolean is_success = FALSE;
-    is_success = g_input_stream_read_all (context->stream, i, 4,
-                                          &context->priv->bytes_read,
-                                          NULL, NULL);
-    if ((is_success == FALSE) ||
-        (context->priv->bytes_read != 4))
-    {
-        *i = 0;
-        g_input_stream_close (context->stream, NULL, NULL);
+    if (!context_read_data (context, i, 4))
         return FALSE;
-    }
     *i = GUINT32_FROM_LE(*i);
-    context->data_count += 4;
     return TRUE;
 }
 
+/**
+ * context_read_bytes:
+ * @context: a #GHWPContext
+ * @count: number of bytes to read
+ *
+ * Reads @count bytes of the current record at once. When @context walks
+ * memory (see ghwp_context_new_from_bytes()), the result is a view into
+ * the section data and nothing is copied; otherwise the bytes are copied
+ * once.
+ *
+ * Returns: (transfer full): a #GBytes, or %NULL if the record is too short
+ */
+GBytes *context_read_bytes (GHWPContext *context, guint32 count)
+{
+    GBytes *bytes;
+
+    g_return_val_if_fail (context != NULL, NULL);
+    g_return_val_if_fail (count <= context->data_len - context->data_count,
+                          NULL);
+
+    if (context->priv->bytes) {
+        gsize offset = (gsize) (context->priv->data + context->data_count -
+                                (const guint8 *) g_bytes_get_data (context->priv->bytes, NULL));
+        bytes = g_bytes_new_from_bytes (context->priv->bytes, offset, count);
+    } else {
+        if (context->priv->data == NULL && !context_load (context))
+            return NULL;
+
+        bytes = g_bytes_new (context->priv->data + context->data_count, count);
+    }
+
+    context->data_count += count;
+    return bytes;
+}
+
+/* 현재 레코드의 데이터를 복사하지 않고 빌려 준다.
+ * 다음 ghwp_context_pull 전까지만 유효하다. */
+const guint8 *context_read_ptr (GHWPContext *context, guint32 count)
+{
+    const guint8 *ptr;
+
+    g_return_val_if_fail (context != NULL, NULL);
+    g_return_val_if_fail (count <= context->data_len - context->data_count,
+                          NULL);
+
+    if (context->priv->data == NULL && !context_load (context))
+        return NULL;
+
+    ptr = context->priv->data + context->data_count;
+    context->data_count += count;
+    return ptr;
+}
+
+static inline gboolean
+field_is_present (GHWPContext *context, const GHWPField *field)
+{
+    const guint8 *v = field->version;
+
+    if (v[0] == 0 && v[1] == 0 && v[2] == 0 && v[3] == 0)
+        return TRUE;
+
+    return context_check_version (context, v[0], v[1], v[2], v[3]) !=
+           field->before;
+}
+
+/* 크기가 같은 원소들을 한 번에 옮긴다.
+ * 리틀 엔디안에서는 그냥 memcpy 이다. */
+static inline void
+field_copy (guint8 *dest, const guint8 *src, gsize len, guint width)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    memcpy (dest, src, len);
+#else
+    gsize i;
+    guint j;
+
+    for (i = 0; i < len; i += width)
+        for (j = 0; j < width; j++)
+            dest[i + j] = src[i + width - 1 - j];
+#endif
+}
+
+/* 크기가 다른 원소 하나를 늘리거나 줄여서 저장한다 */
+static void
+field_convert (guint8 *dest, const guint8 *src, const GHWPField *field)
+{
+    guint32 value = 0;
+    guint   j;
+
+    for (j = 0; j < field->width; j++)
+        value |= (guint32) src[j] << (j * 8);
+
+    if (field->is_signed && field->width < 4 &&
+        (value & (1U << (field->width * 8 - 1))))
+        value |= ~0U << (field->width * 8);
+
+    switch (field->dest_width) {
+    case 1:
+        *(guint8 *) dest = (guint8) value;
+        break;
+    case 2:
+        *(guint16 *) dest = (guint16) value;
+        break;
+    case 4:
+        *(guint32 *) dest = value;
+        break;
+    case 8:
+        *(guint64 *) dest = field->is_signed ? (guint64) (gint64) (gint32) value
+                                             : (guint64) value;
+        break;
+    default:
+        g_warn_if_reached ();
+        break;
+    }
+}
+
+/**
+ * context_decode:
+ * @context: a #GHWPContext
+ * @fields: descriptors of the fields, in record order
+ * @n_fields: number of @fields
+ * @dest: the structure to store the fields
+ *
+ * Decodes the fixed-layout part of the current record, starting at the
+ * current position, into @dest. The record size is checked once for all
+ * fields and the data is copied without going through the per-field
+ * readers; runs of fields laid out the same way in the record and in
+ * @dest are copied at once.
+ *
+ * If the record is shorter than the fields, the fields which fit are
+ * still decoded and a warning is printed.
+ *
+ * Returns: %TRUE if all fields were decoded
+ */
+gboolean context_decode (GHWPContext     *context,
+                         const GHWPField *fields,
+                         guint            n_fields,
+                         gpointer         dest)
+{
+    const guint8 *data;
+    guint8       *base = dest;
+    guint8       *run_dest = NULL;
+    const guint8 *run_src = NULL;
+    gsize         run_len = 0;
+    guint         run_width = 0;
+    guint32       size = 0;
+    guint32       avail;
+    guint32       pos = 0;
+    guint         i, k;
+
+    g_return_val_if_fail (context != NULL, FALSE);
+    g_return_val_if_fail (fields != NULL, FALSE);
+    g_return_val_if_fail (dest != NULL, FALSE);
+
+    for (i = 0; i < n_fields; i++) {
+        if (field_is_present (context, &fields[i]))
+            size += (guint32) fields[i].width * fields[i].count;
+    }
+
+    avail = context->data_len - context->data_count;
+    if (G_UNLIKELY (size > avail)) {
+        g_warning ("%s:%d: record %u size mismatch (%u < %u)\n",
+                   __FILE__, __LINE__, context->tag_id, avail, size);
+    }
+
+    data = context_read_ptr (context, MIN (size, avail));
+    if (data == NULL)
+        return FALSE;
+
+    for (i = 0; i < n_fields; i++) {
+        const GHWPField *field = &fields[i];
+        guint32          len = (guint32) field->width * field->count;
+
+        if (!field_is_present (context, field))
+            continue;
+
+        if (pos + len > avail)
+            break;
+
+        if (field->dest_width == field->width) {
+            guint8 *d = base + field->dest;
+
+            /* 앞의 필드와 이어져 있으면 함께 옮긴다 */
+            if (run_len > 0 && run_width == field->width &&
+                run_dest + run_len == d && run_src + run_len == data + pos) {
+                run_len += len;
+            } else {
+                if (run_len > 0)
+                    field_copy (run_dest, run_src, run_len, run_width);
+
+                run_dest  = d;
+                run_src   = data + pos;
+                run_len   = len;
+                run_width = field->width;
+            }
+        } else if (field->dest_width > 0) {
+            for (k = 0; k < field->count; k++)
+                field_convert (base + field->dest + k * field->dest_width,
+                               data + pos + k * field->width, field);
+        }
+
+        pos += len;
+    }
+
+    if (run_len > 0)
+        field_copy (run_dest, run_src, run_len, run_width);
+
+    return size <= avail;
+}
+
 gchar *context_read_string_n (GHWPContext *context, guint n)
 {
     gunichar2 ch;
@@ -297,6 +498,166 @@ GHWPContext* ghwp_context_new (GInputStream* stream)
     return context;
 }
 
+/**
+ * ghwp_context_new_from_bytes:
+ * @bytes: a #GBytes holding a whole (decompressed) record stream
+ *
+ * Creates a #GHWPContext which walks the records in @bytes with a cursor.
+ * Record data is not copied; the context only points into @bytes.
+ *
+ * Returns: a new #GHWPContext
+ */
+GHWPContext *ghwp_context_new_from_bytes (GBytes *bytes)
+{
+    g_return_val_if_fail (bytes != NULL, NULL);
+    GHWPContext *context = g_object_new (GHWP_TYPE_CONTEXT, NULL);
+    context->priv->bytes = g_bytes_ref (bytes);
+    context->priv->pos   = 0;
+    return context;
+}
+
+/**
+ * ghwp_context_set_cancellable:
+ * @context: a #GHWPContext
+ * @cancellable: (allow-none): a #GCancellable, or %NULL
+ *
+ * Makes ghwp_context_pull() fail with %G_IO_ERROR_CANCELLED once
+ * @cancellable is cancelled. Reads from the stream are cancelled too.
+ */
+void ghwp_context_set_cancellable (GHWPContext  *context,
+                                   GCancellable *cancellable)
+{
+    g_return_if_fail (GHWP_IS_CONTEXT (context));
+
+    if (cancellable)
+        g_object_ref (cancellable);
+    _g_object_unref0 (context->priv->cancellable);
+    context->priv->cancellable = cancellable;
+}
+
+/**
+ * ghwp_context_seek:
+ * @context: a #GHWPContext created by ghwp_context_new_from_bytes()
+ * @offset: byte offset of a record header
+ *
+ * Moves the cursor so that the next ghwp_context_pull() returns the
+ * record starting at @offset. This allows re-parsing and random access.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean ghwp_context_seek (GHWPContext *context, gsize offset)
+{
+    g_return_val_if_fail (context != NULL, FALSE);
+    g_return_val_if_fail (context->priv->bytes != NULL, FALSE);
+    g_return_val_if_fail (offset <= g_bytes_get_size (context->priv->bytes),
+                          FALSE);
+
+    context->priv->pos  = offset;
+    context->data_len   = 0;
+    context->data_count = 0;
+    return TRUE;
+}
+
+/**
+ * ghwp_context_set_record:
+ * @context: a #GHWPContext created by ghwp_context_new_from_bytes()
+ * @record: a record found by a #GHWPRecordIndex of the same section
+ *
+ * Makes @record the current record, as if ghwp_context_pull() had just
+ * returned it. The next ghwp_context_pull() continues after @record.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean ghwp_context_set_record (GHWPContext      *context,
+                                  const GHWPRecord *record)
+{
+    gsize         size;
+    const guint8 *data;
+    gsize         pos;
+    guint32       header;
+
+    g_return_val_if_fail (context != NULL, FALSE);
+    g_return_val_if_fail (record != NULL, FALSE);
+    g_return_val_if_fail (context->priv->bytes != NULL, FALSE);
+
+    data = g_bytes_get_data (context->priv->bytes, &size);
+    pos  = record->offset;
+    g_return_val_if_fail (pos <= size && size - pos >= 4, FALSE);
+
+    /* 헤더 뒤에 32비트 길이가 있는지 본다 */
+    memcpy (&header, data + pos, 4);
+    pos += ((GUINT32_FROM_LE(header) >> 20) & 0xfff) == 0xfff ? 8 : 4;
+    g_return_val_if_fail (pos <= size && size - pos >= record->data_len, FALSE);
+
+    context->tag_id     = record->tag_id;
+    context->level      = record->level;
+    context->data_len   = record->data_len;
+    context->data_count = 0;
+    context->priv->data = data + pos;
+    context->priv->pos  = pos + record->data_len;
+
+    return TRUE;
+}
+
+/* 메모리 위의 레코드를 읽는다. 데이터는 복사하지 않는다. */
+static gboolean ghwp_context_pull_bytes (GHWPContext *context, GError **error)
+{
+    gsize         size;
+    const guint8 *data = g_bytes_get_data (context->priv->bytes, &size);
+    gsize         pos  = context->priv->pos;
+    guint32       len;
+
+    /* 스트림의 끝, 에러가 아님 */
+    if (pos == size)
+        return FALSE;
+
+    if (g_cancellable_set_error_if_cancelled (context->priv->cancellable,
+                                              error))
+        return FALSE;
+
+    /* 비정상 */
+    if (size - pos < 4) {
+        g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                             _("File corrupted"));
+        return FALSE;
+    }
+
+    memcpy (&context->priv->header, data + pos, 4);
+    pos += 4;
+
+    /* 4바이트 헤더 디코딩하기 */
+    context->priv->header = GUINT32_FROM_LE(context->priv->header);
+    context->tag_id = (guint16) ( context->priv->header        & 0x3ff);
+    context->level  = (guint16) ((context->priv->header >> 10) & 0x3ff);
+    len             = (guint32) ((context->priv->header >> 20) & 0xfff);
+
+    /* data_len == 0xfff 이면 다음 4바이트는 data_len 이다 */
+    if (len == 0xfff) {
+        if (size - pos < 4) {
+            g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                                 _("File corrupted"));
+            return FALSE;
+        }
+        memcpy (&len, data + pos, 4);
+        len = GUINT32_FROM_LE(len);
+        pos += 4;
+    }
+
+    /* 비정상 */
+    if (len == 0 || size - pos < len) {
+        g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                             _("File corrupted"));
+        return FALSE;
+    }
+
+    context->data_len   = len;
+    context->data_count = 0;
+    context->priv->data = data + pos;
+    context->priv->pos  = pos + len;
+
+    return TRUE;
+}
+
 /* 에러일 경우 FALSE 반환, error 설정,
  * 성공일 경우 TRUE 반환,
  * end-of-stream 일 경우 FALSE 반환, error 설정 안 함 */
@@ -304,14 +665,39 @@ gboolean ghwp_context_pull (GHWPContext *context, GError **error)
 {
     g_return_val_if_fail (context != NULL, FALSE);
     gboolean is_success = TRUE;
-    if (context->data_len - context->data_count > 0)
-        context_skip (context, context->data_len - context->data_count);
+
+    if (context->priv->bytes)
+        return ghwp_context_pull_bytes (context, error);
+
+    /* 이전 레코드를 읽다가 난 에러 */
+    if (context->priv->error) {
+        g_propagate_error (error, context->priv->error);
+        context->priv->error = NULL;
+        g_input_stream_close (context->stream, NULL, NULL);
+        return FALSE;
+    }
+
+    /* 한 번도 읽지 않은 이전 레코드의 데이터는 건너뛴다 */
+    if (context->priv->data == NULL && context->data_len > 0) {
+        is_success = context_check_data_len (context, error) &&
+                     _ghwp_input_stream_skip (context->stream,
+                                              (gsize) context->data_len,
+                                              context->priv->scratch,
+                                              sizeof (context->priv->scratch),
+                                              context->priv->cancellable,
+                                              error);
+        if (is_success == FALSE) {
+            g_input_stream_close (context->stream, NULL, NULL);
+            return FALSE;
+        }
+    }
+
     /* 4바이트 읽기 */
     is_success = g_input_stream_read_all (context->stream,
                                           &context->priv->header,
                                           (gsize) 4,
                                           &context->priv->bytes_read,
-                                          NULL, error);
+                                          context->priv->cancellable, error);
 
     if (is_success == FALSE) {
         /* g_input_stream_read_all이 에러를 설정했으므로
@@ -337,7 +723,7 @@ gboolean ghwp_context_pull (GHWPContext *context, GError **error)
     /* 4바이트 헤더 디코딩하기 */
     context->tag_id   = (guint16) ( context->priv->header        & 0x3ff);
     context->level    = (guint16) ((context->priv->header >> 10) & 0x3ff);
-    context->data_len = (guint16) ((context->priv->header >> 20) & 0xfff);
+    context->data_len = (guint32) ((context->priv->header >> 20) & 0xfff);
     /* 비정상 */
     if (context->data_len == 0) {
         g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
@@ -347,10 +733,13 @@ gboolean ghwp_context_pull (GHWPContext *context, GError **error)
     }
     /* data_len == 0xfff 이면 다음 4바이트는 data_len 이다 */
     if (context->data_len == 0xfff) {
+        guint32 len;
+
         is_success = g_input_stream_read_all (context->stream,
-                                              &context->data_len, (gsize) 4,
+                                              &len, (gsize) 4,
                                               &context->priv->bytes_read,
-                                              NULL, error);
+                                              context->priv->cancellable,
+                                              error);
 
         if (is_success == FALSE) {
             /* g_input_stream_read_all이 에러를 설정했으므로
@@ -367,10 +756,12 @@ gboolean ghwp_context_pull (GHWPContext *context, GError **error)
             return FALSE;
         }
 
-        context->data_len = GUINT32_FROM_LE(context->data_len);
+        context->data_len = GUINT32_FROM_LE(len);
     }
 
+    /* 레코드 데이터는 필요할 때 읽는다 */
     context->data_count = 0;
+    context->priv->data = NULL;
 
     return TRUE;
 }
@@ -395,8 +786,14 @@ static void ghwp_context_init (GHWPContext * context)
 static void ghwp_context_finalize (GObject *obj)
 {
     GHWPContext *context = GHWP_CONTEXT(obj);
-    g_input_stream_close (context->stream, NULL, NULL);
-    g_object_unref (context->stream);
-/*    context->data = (g_free (context->data), NULL);*/
+    if (context->stream) {
+        g_input_stream_close (context->stream, NULL, NULL);
+        g_object_unref (context->stream);
+    }
+    if (context->priv->bytes)
+        g_bytes_unref (context->priv->bytes);
+    g_free (context->priv->buf);
+    _g_error_free0 (context->priv->error);
+    _g_object_unref0 (context->priv->cancellable);
     G_OBJECT_CLASS (ghwp_context_parent_class)->finalize (obj);
 }
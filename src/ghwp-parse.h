@@ -66,8 +66,8 @@ struct _GHWPContext {
     GInputStream       *stream;
     guint16             tag_id;
     guint16             level;
-    guint16             data_len;
-    guint16             data_count;
+    guint32             data_len;
+    guint32             data_count;
     guint8              version[4];
     GHWPContextStatus   status[GHWP_MAX_STATE];
 };
@@ -76,14 +76,83 @@ struct _GHWPContextClass {
     GObjectClass parent_class;
 };
 
+#define GHWP_CONTEXT_SCRATCH_SIZE 4096
+
 struct _GHWPContextPrivate {
     guint32           header;
     gsize             bytes_read;
     gboolean          ret;
+    guint8           *buf;       /* 스트림에서 읽은 레코드 데이터 */
+    gsize             buf_size;
+    const guint8     *data;      /* 현재 레코드의 데이터, 아직 안 읽었으면 NULL */
+    GBytes           *bytes;     /* 메모리 위의 레코드들 */
+    gsize             pos;       /* 다음 레코드의 위치 */
+    GError           *error;     /* 레코드 데이터를 읽다가 난 에러 */
+    GCancellable     *cancellable;
+    guint8            scratch[GHWP_CONTEXT_SCRATCH_SIZE]; /* 건너뛰기용 */
+};
+
+/*
+ * 고정된 모양의 레코드 앞부분을 읽기 위한 필드 서술자.
+ *
+ * 필드는 파일에 나오는 순서대로 적고, 파일 안의 위치는 앞 필드들의
+ * 크기로 정해진다. 버전에 따라 있거나 없는 필드는 GHWP_FIELD_SINCE,
+ * GHWP_FIELD_BEFORE 로 적는다. 파일의 크기와 구조체 멤버의 크기가
+ * 다르면 is_signed 에 따라 늘리거나 줄여서 저장한다.
+ */
+typedef struct _GHWPField GHWPField;
+
+struct _GHWPField {
+    guint16  dest;        /* 구조체 안에서 멤버의 위치, 건너뛸 때는 0 */
+    guint8   dest_width;  /* 멤버 (배열이면 원소 하나) 의 크기, 건너뛸 때는 0 */
+    guint8   count;       /* 원소 개수 */
+    guint8   width;       /* 파일 안에서 원소 하나의 크기 */
+    guint8   is_signed;
+    guint8   before;      /* version 보다 낮은 버전에만 있다 */
+    guint8   version[4];  /* 이 필드가 생긴 버전 */
 };
 
+#define GHWP_U8   1, FALSE
+#define GHWP_I8   1, TRUE
+#define GHWP_U16  2, FALSE
+#define GHWP_I16  2, TRUE
+#define GHWP_U32  4, FALSE
+#define GHWP_I32  4, TRUE
+
+#define GHWP_FIELD_N(type, member, n, kind)                             \
+    { G_STRUCT_OFFSET (type, member),                                   \
+      sizeof (((type *) 0)->member) / (n), (n), kind, FALSE,           \
+      { 0, 0, 0, 0 } }
+
+#define GHWP_FIELD(type, member, kind)                                  \
+    { G_STRUCT_OFFSET (type, member),                                   \
+      sizeof (((type *) 0)->member), 1, kind, FALSE,                   \
+      { 0, 0, 0, 0 } }
+
+#define GHWP_FIELD_SINCE(type, member, kind, major, minor, micro, extra) \
+    { G_STRUCT_OFFSET (type, member),                                   \
+      sizeof (((type *) 0)->member), 1, kind, FALSE,                   \
+      { major, minor, micro, extra } }
+
+#define GHWP_FIELD_BEFORE(type, member, kind, major, minor, micro, extra) \
+    { G_STRUCT_OFFSET (type, member),                                   \
+      sizeof (((type *) 0)->member), 1, kind, TRUE,                    \
+      { major, minor, micro, extra } }
+
+#define GHWP_FIELD_SKIP(n_bytes) \
+    { 0, 0, (n_bytes), GHWP_U8, FALSE, { 0, 0, 0, 0 } }
+
 GType        ghwp_context_get_type   (void) G_GNUC_CONST;
 GHWPContext *ghwp_context_new        (GInputStream *stream);
+GHWPContext *ghwp_context_new_from_bytes
+                                     (GBytes       *bytes);
+gboolean     ghwp_context_seek       (GHWPContext  *context,
+                                      gsize         offset);
+void         ghwp_context_set_cancellable
+                                     (GHWPContext  *context,
+                                      GCancellable *cancellable);
+gboolean     ghwp_context_set_record (GHWPContext  *context,
+                                      const GHWPRecord *record);
 gboolean     ghwp_context_pull       (GHWPContext  *context,
 				      GError **error);
 gboolean     context_read_int8       (GHWPContext  *context,
@@ -105,7 +174,15 @@ gboolean     context_read_hwp_unit16 (GHWPContext  *context,
 gboolean     context_read_hwp_color  (GHWPContext  *context,
                                       ghwp_color   *i);
 gboolean     context_skip            (GHWPContext  *context,
-                                      guint16       count);
+                                      guint32       count);
+GBytes      *context_read_bytes      (GHWPContext  *context,
+                                      guint32       count);
+const guint8 *context_read_ptr       (GHWPContext  *context,
+                                      guint32       count);
+gboolean     context_decode          (GHWPContext     *context,
+                                      const GHWPField *fields,
+                                      guint            n_fields,
+                                      gpointer         dest);
 gchar       *context_read_string_n   (GHWPContext *context,
 				      guint n);
 gchar       *context_read_string     (GHWPContext *context);
@@ -0,0 +1,127 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-private.h
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 라이브러리 안에서만 쓰는 선언. 설치하지 않는다.
+ */
+
+#ifndef __GHWP_PRIVATE_H__
+#define __GHWP_PRIVATE_H__
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "ghwp-file.h"
+#include "ghwp-record-index.h"
+#include "ghwp-text-arena.h"
+
+G_BEGIN_DECLS
+
+/* 압축을 푼 섹션 하나의 최대 크기. 레코드도 이보다 길 수 없다. */
+#define GHWP_SECTION_MAX_SIZE  ((gsize) 512 * 1024 * 1024)
+
+/* GPtrArray 의 free_func 로 쓴다 */
+static inline void _g_object_unref0_ (gpointer var)
+{
+    (var == NULL) ? NULL : (var = (g_object_unref (var), NULL));
+}
+
+static inline void _g_bytes_unref0_ (gpointer var)
+{
+    (var == NULL) ? NULL : (var = (g_bytes_unref (var), NULL));
+}
+
+/* ghwp.c */
+gboolean  _ghwp_input_stream_skip          (GInputStream   *stream,
+                                            gsize           count,
+                                            guint8         *scratch,
+                                            gsize           scratch_size,
+                                            GCancellable   *cancellable,
+                                            GError        **error);
+
+/* ghwp-file.c */
+GHWPFile *_ghwp_file_new_from_gfile        (GFile          *file,
+                                            GHWPOpenFlags   flags,
+                                            GCancellable   *cancellable,
+                                            GError        **error);
+GCancellable *_ghwp_file_get_cancellable   (GHWPFile       *file);
+void      _ghwp_file_begin_progress        (GHWPFile       *file);
+void      _ghwp_file_end_progress          (GHWPFile       *file);
+void      _ghwp_file_report_progress       (GHWPFile       *file,
+                                            gsize           bytes_read,
+                                            guint           n_sections_done,
+                                            guint           n_sections);
+
+/* ghwp-file-v5.c */
+GHWPFileV5 *_ghwp_file_v5_new_from_mapping (GBytes         *bytes,
+                                            const gchar    *filename,
+                                            GHWPOpenFlags   flags,
+                                            GError        **error);
+GBytes   *_ghwp_file_v5_ref_section_data   (GHWPFileV5     *file,
+                                            guint           index,
+                                            GError        **error);
+
+/* ghwp-document.c */
+void      _ghwp_document_set_body_pending  (GHWPDocument   *doc);
+GHWPSearchIndex *_ghwp_document_get_search_index
+                                           (GHWPDocument   *doc);
+void      _ghwp_document_set_search_index  (GHWPDocument   *doc,
+                                            GHWPSearchIndex *index);
+void      _ghwp_document_set_page_table    (GHWPDocument   *doc,
+                                            const guint    *n_pages,
+                                            const gdouble  *sizes,
+                                            guint           n_sections);
+void      _ghwp_document_set_section_pages (GHWPDocument   *doc,
+                                            guint           index,
+                                            GHWPPage      **pages,
+                                            guint           n_pages);
+
+/* ghwp-models.c */
+void      _ghwp_text_set_buf               (GHWPText       *ghwp_text,
+                                            gunichar2      *buf,
+                                            guint           n_chars,
+                                            GHWPTextArena  *arena);
+
+/* ghwp-record-index.c */
+GHWPRecordIndex *_ghwp_record_index_new_from_tables
+                                           (GBytes         *records,
+                                            GBytes         *paragraphs,
+                                            GBytes         *page_marks,
+                                            gsize           section_size,
+                                            ghwp_unit       page_h_size,
+                                            ghwp_unit       page_v_size);
+
+/* ghwp-cache.c */
+gchar    *_ghwp_cache_get_path             (const gchar    *filename,
+                                            GBytes         *file_header,
+                                            GBytes         *doc_info);
+gboolean  _ghwp_cache_load                 (const gchar    *path,
+                                            guint           n_sections,
+                                            GPtrArray     **record_index,
+                                            GPtrArray     **section_data);
+gboolean  _ghwp_cache_store                (const gchar    *path,
+                                            GPtrArray      *record_index,
+                                            GPtrArray      *section_data,
+                                            GError        **error);
+gchar    *_ghwp_cache_get_search_index_path (const gchar   *path);
+
+G_END_DECLS
+
+#endif /* __GHWP_PRIVATE_H__ */
@@ -0,0 +1,414 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-record-index.c
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <glib/gi18n-lib.h>
+
+#include "ghwp-record-index.h"
+#include "ghwp-private.h"
+
+G_DEFINE_TYPE (GHWPRecordIndex, ghwp_record_index, G_TYPE_OBJECT);
+
+#define GHWP_RECORD_INDEX_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), GHWP_TYPE_RECORD_INDEX, GHWPRecordIndexPrivate))
+
+/* PARA_HEADER 에서 n_line_segs 의 위치 */
+#define PARA_HEADER_N_LINE_SEGS_OFFSET  16
+/* PARA_LINE_SEG 한 줄의 크기와 v_pos 의 위치 */
+#define LINE_SEG_SIZE                   36
+#define LINE_SEG_V_POS_OFFSET           4
+
+static inline guint16 read_uint16 (const guint8 *p)
+{
+    guint16 i;
+    memcpy (&i, p, 2);
+    return GUINT16_FROM_LE(i);
+}
+
+static inline guint32 read_uint32 (const guint8 *p)
+{
+    guint32 i;
+    memcpy (&i, p, 4);
+    return GUINT32_FROM_LE(i);
+}
+
+static GBytes *array_free_to_bytes (GArray *array)
+{
+    gsize size = array->len * g_array_get_element_size (array);
+    return g_bytes_new_take (g_array_free (array, FALSE), size);
+}
+
+static void
+ghwp_record_index_set_tables (GHWPRecordIndex *index,
+                              GBytes          *records,
+                              GBytes          *paragraphs,
+                              GBytes          *page_marks)
+{
+    GHWPRecordIndexPrivate *priv = index->priv;
+
+    priv->records        = records;
+    priv->paragraphs     = paragraphs;
+    priv->page_marks     = page_marks;
+    priv->n_records      = g_bytes_get_size (records)    / sizeof (GHWPRecord);
+    priv->n_paragraphs   = g_bytes_get_size (paragraphs) / sizeof (guint32);
+    priv->n_page_marks   = g_bytes_get_size (page_marks) / sizeof (GHWPPageMark);
+    priv->record_data    = g_bytes_get_data (records,    NULL);
+    priv->paragraph_data = g_bytes_get_data (paragraphs, NULL);
+    priv->page_mark_data = g_bytes_get_data (page_marks, NULL);
+}
+
+/* 레코드 헤더만 읽으며 섹션 전체를 훑는다. 데이터를 읽는 것은 level 0
+ * 문단의 n_line_segs 와 그 줄들의 v_pos, 그리고 용지 크기뿐이다. */
+static gboolean
+ghwp_record_index_scan (GHWPRecordIndex *index,
+                        GBytes          *section_data,
+                        GError         **error)
+{
+    gsize         size;
+    const guint8 *data = g_bytes_get_data (section_data, &size);
+    gsize         pos  = 0;
+    guint16       n_line_segs = 0;
+    ghwp_unit     page_h_size = 0;
+    ghwp_unit     page_v_size = 0;
+    GArray       *records;
+    GArray       *paragraphs;
+    GArray       *page_marks;
+
+    /* 위치를 32비트로 저장한다 */
+    if (size > G_MAXUINT32) {
+        g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                             _("File corrupted"));
+        return FALSE;
+    }
+
+    records    = g_array_sized_new (FALSE, FALSE, sizeof (GHWPRecord),
+                                    size / 32);
+    paragraphs = g_array_new (FALSE, FALSE, sizeof (guint32));
+    page_marks = g_array_new (FALSE, FALSE, sizeof (GHWPPageMark));
+
+    /* 헤더가 깨진 레코드를 만나면 섹션이 거기서 잘렸다고 보고 그 앞까지
+     * 읽은 레코드만 쓴다 */
+    while (pos < size) {
+        GHWPRecord record;
+        guint32    header;
+        guint32    len;
+        gsize      data_pos;
+
+        if (size - pos < 4)
+            break;
+
+        header   = read_uint32 (data + pos);
+        len      = (header >> 20) & 0xfff;
+        data_pos = pos + 4;
+
+        /* data_len == 0xfff 이면 다음 4바이트는 data_len 이다 */
+        if (len == 0xfff) {
+            if (size - data_pos < 4)
+                break;
+            len = read_uint32 (data + data_pos);
+            data_pos += 4;
+        }
+
+        /* 비정상 */
+        if (len == 0 || size - data_pos < len)
+            break;
+
+        record.tag_id   = (guint16) ( header        & 0x3ff);
+        record.level    = (guint16) ((header >> 10) & 0x3ff);
+        record.offset   = (guint32) pos;
+        record.data_len = len;
+
+        if (record.level == 0 && record.tag_id == GHWP_TAG_PARA_HEADER) {
+            guint32 i = records->len;
+
+            g_array_append_val (paragraphs, i);
+
+            if (len >= PARA_HEADER_N_LINE_SEGS_OFFSET + 2)
+                n_line_segs = read_uint16 (data + data_pos +
+                                           PARA_HEADER_N_LINE_SEGS_OFFSET);
+            else
+                n_line_segs = 0;
+
+        } else if (record.level == 1 &&
+                   record.tag_id == GHWP_TAG_PARA_LINE_SEG &&
+                   paragraphs->len > 0) {
+            guint n;
+
+            for (n = 0; n < n_line_segs && (n + 1) * LINE_SEG_SIZE <= len; n++) {
+                const guint8 *line = data + data_pos + n * LINE_SEG_SIZE;
+                GHWPPageMark  mark;
+
+                if (read_uint32 (line + LINE_SEG_V_POS_OFFSET) != 0)
+                    continue;
+
+                mark.paragraph = paragraphs->len - 1;
+                mark.line_seg  = (guint16) n;
+                mark.reserved  = 0;
+                g_array_append_val (page_marks, mark);
+            }
+
+        } else if (record.tag_id == GHWP_TAG_PAGE_DEF) {
+            /* 섹션을 만들 때처럼 마지막 용지 설정을 쓴다 */
+            if (len >= 4)
+                page_h_size = read_uint32 (data + data_pos);
+            if (len >= 8)
+                page_v_size = read_uint32 (data + data_pos + 4);
+        }
+
+        g_array_append_val (records, record);
+        pos = data_pos + len;
+    }
+
+    if (pos < size)
+        g_warning ("%s:%d: section truncated at offset %" G_GSIZE_FORMAT,
+                   __FILE__, __LINE__, pos);
+
+    ghwp_record_index_set_tables (index, array_free_to_bytes (records),
+                                  array_free_to_bytes (paragraphs),
+                                  array_free_to_bytes (page_marks));
+    index->priv->section_size = size;
+    index->priv->page_h_size  = page_h_size;
+    index->priv->page_v_size  = page_v_size;
+
+    return TRUE;
+}
+
+/**
+ * ghwp_record_index_new:
+ * @section_data: a decompressed section, see ghwp_file_v5_get_section_data()
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Scans the record headers of @section_data and builds a table of
+ * (tag, level, offset, length) for every record, together with the
+ * level 0 paragraphs and the line segments which start a new page.
+ * A record can be parsed later with ghwp_context_set_record().
+ * If a record header is damaged, the section is treated as truncated
+ * and only the records before it are indexed.
+ *
+ * Returns: a new #GHWPRecordIndex, or %NULL on error
+ */
+GHWPRecordIndex *ghwp_record_index_new (GBytes *section_data, GError **error)
+{
+    GHWPRecordIndex *index;
+
+    g_return_val_if_fail (section_data != NULL, NULL);
+
+    index = g_object_new (GHWP_TYPE_RECORD_INDEX, NULL);
+
+    if (!ghwp_record_index_scan (index, section_data, error)) {
+        g_object_unref (index);
+        return NULL;
+    }
+
+    return index;
+}
+
+/* 캐시에서 읽은 표로 인덱스를 만든다. 표는 복사하지 않는다.
+ * 표끼리 맞지 않거나 레코드가 section_size 바이트 섹션 안에 차례로
+ * 놓이지 않으면 NULL 을 반환한다. */
+GHWPRecordIndex *_ghwp_record_index_new_from_tables (GBytes    *records,
+                                                     GBytes    *paragraphs,
+                                                     GBytes    *page_marks,
+                                                     gsize      section_size,
+                                                     ghwp_unit  page_h_size,
+                                                     ghwp_unit  page_v_size)
+{
+    GHWPRecordIndex *index;
+    guint            i;
+    guint64          end = 0;
+
+    g_return_val_if_fail (records    != NULL, NULL);
+    g_return_val_if_fail (paragraphs != NULL, NULL);
+    g_return_val_if_fail (page_marks != NULL, NULL);
+
+    index = g_object_new (GHWP_TYPE_RECORD_INDEX, NULL);
+    ghwp_record_index_set_tables (index, g_bytes_ref (records),
+                                  g_bytes_ref (paragraphs),
+                                  g_bytes_ref (page_marks));
+    index->priv->section_size = section_size;
+    index->priv->page_h_size  = page_h_size;
+    index->priv->page_v_size  = page_v_size;
+
+    /* 레코드는 앞 레코드가 끝난 뒤에 시작해야 한다. data_len 이 0xfff
+     * 이상이면 헤더 뒤에 32비트 길이가 붙는다. */
+    for (i = 0; i < index->priv->n_records; i++) {
+        const GHWPRecord *record = &index->priv->record_data[i];
+        guint64 header_size = record->data_len >= 0xfff ? 8 : 4;
+
+        if (record->offset < end)
+            goto invalid;
+
+        end = (guint64) record->offset + header_size + record->data_len;
+        if (end > section_size)
+            goto invalid;
+    }
+
+    for (i = 0; i < index->priv->n_paragraphs; i++) {
+        if (index->priv->paragraph_data[i] >= index->priv->n_records)
+            goto invalid;
+    }
+
+    for (i = 0; i < index->priv->n_page_marks; i++) {
+        if (index->priv->page_mark_data[i].paragraph >= index->priv->n_paragraphs)
+            goto invalid;
+    }
+
+    return index;
+
+invalid:
+    g_object_unref (index);
+    return NULL;
+}
+
+guint ghwp_record_index_get_n_records (GHWPRecordIndex *index)
+{
+    g_return_val_if_fail (GHWP_IS_RECORD_INDEX (index), 0);
+    return index->priv->n_records;
+}
+
+/**
+ * ghwp_record_index_get_record:
+ * @index: a #GHWPRecordIndex
+ * @i: the number of the record
+ *
+ * Returns: (transfer none): the @i-th record of the section
+ */
+const GHWPRecord *ghwp_record_index_get_record (GHWPRecordIndex *index,
+                                                guint            i)
+{
+    g_return_val_if_fail (GHWP_IS_RECORD_INDEX (index), NULL);
+    g_return_val_if_fail (i < index->priv->n_records, NULL);
+    return &index->priv->record_data[i];
+}
+
+guint ghwp_record_index_get_n_paragraphs (GHWPRecordIndex *index)
+{
+    g_return_val_if_fail (GHWP_IS_RECORD_INDEX (index), 0);
+    return index->priv->n_paragraphs;
+}
+
+/**
+ * ghwp_record_index_get_paragraph:
+ * @index: a #GHWPRecordIndex
+ * @paragraph: the number of a level 0 paragraph in the section
+ *
+ * Returns: the number of the PARA_HEADER record of @paragraph
+ */
+guint ghwp_record_index_get_paragraph (GHWPRecordIndex *index,
+                                       guint            paragraph)
+{
+    g_return_val_if_fail (GHWP_IS_RECORD_INDEX (index), 0);
+    g_return_val_if_fail (paragraph < index->priv->n_paragraphs, 0);
+    return index->priv->paragraph_data[paragraph];
+}
+
+guint ghwp_record_index_get_n_page_marks (GHWPRecordIndex *index)
+{
+    g_return_val_if_fail (GHWP_IS_RECORD_INDEX (index), 0);
+    return index->priv->n_page_marks;
+}
+
+/**
+ * ghwp_record_index_get_page_mark:
+ * @index: a #GHWPRecordIndex
+ * @i: the number of the page in the section
+ *
+ * Returns: (transfer none): where the @i-th page of the section starts
+ */
+const GHWPPageMark *ghwp_record_index_get_page_mark (GHWPRecordIndex *index,
+                                                     guint            i)
+{
+    g_return_val_if_fail (GHWP_IS_RECORD_INDEX (index), NULL);
+    g_return_val_if_fail (i < index->priv->n_page_marks, NULL);
+    return &index->priv->page_mark_data[i];
+}
+
+/**
+ * ghwp_record_index_find:
+ * @index: a #GHWPRecordIndex
+ * @tag_id: a #GHWPTag
+ * @from: the number of the record to start from
+ *
+ * Returns: the number of the first record with @tag_id at or after
+ * @from, or -1 if there is none
+ */
+gint ghwp_record_index_find (GHWPRecordIndex *index,
+                             guint16          tag_id,
+                             guint            from)
+{
+    guint i;
+
+    g_return_val_if_fail (GHWP_IS_RECORD_INDEX (index), -1);
+
+    for (i = from; i < index->priv->n_records; i++) {
+        if (index->priv->record_data[i].tag_id == tag_id)
+            return (gint) i;
+    }
+
+    return -1;
+}
+
+/**
+ * ghwp_record_index_get_page_size:
+ * @index: a #GHWPRecordIndex
+ * @h_size: (out) (allow-none): return location for the paper width
+ * @v_size: (out) (allow-none): return location for the paper height
+ *
+ * Gets the paper size of the last PAGE_DEF record of the section, in
+ * HWPUNIT, so that the page table can be made without parsing records.
+ */
+void ghwp_record_index_get_page_size (GHWPRecordIndex *index,
+                                      ghwp_unit       *h_size,
+                                      ghwp_unit       *v_size)
+{
+    g_return_if_fail (GHWP_IS_RECORD_INDEX (index));
+
+    if (h_size)
+        *h_size = index->priv->page_h_size;
+    if (v_size)
+        *v_size = index->priv->page_v_size;
+}
+
+static void ghwp_record_index_finalize (GObject *obj)
+{
+    GHWPRecordIndex *index = GHWP_RECORD_INDEX (obj);
+
+    if (index->priv->records)
+        g_bytes_unref (index->priv->records);
+    if (index->priv->paragraphs)
+        g_bytes_unref (index->priv->paragraphs);
+    if (index->priv->page_marks)
+        g_bytes_unref (index->priv->page_marks);
+
+    G_OBJECT_CLASS (ghwp_record_index_parent_class)->finalize (obj);
+}
+
+static void ghwp_record_index_class_init (GHWPRecordIndexClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    g_type_class_add_private (klass, sizeof (GHWPRecordIndexPrivate));
+    object_class->finalize = ghwp_record_index_finalize;
+}
+
+static void ghwp_record_index_init (GHWPRecordIndex *index)
+{
+    index->priv = GHWP_RECORD_INDEX_GET_PRIVATE (index);
+}
+
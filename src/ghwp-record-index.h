@@ -0,0 +1,110 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-record-index.h
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
+ */
+
+#ifndef __GHWP_RECORD_INDEX_H__
+#define __GHWP_RECORD_INDEX_H__
+
+#include <glib-object.h>
+
+#include "ghwp.h"
+
+G_BEGIN_DECLS
+
+#define GHWP_TYPE_RECORD_INDEX             (ghwp_record_index_get_type ())
+#define GHWP_RECORD_INDEX(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GHWP_TYPE_RECORD_INDEX, GHWPRecordIndex))
+#define GHWP_RECORD_INDEX_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GHWP_TYPE_RECORD_INDEX, GHWPRecordIndexClass))
+#define GHWP_IS_RECORD_INDEX(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GHWP_TYPE_RECORD_INDEX))
+#define GHWP_IS_RECORD_INDEX_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GHWP_TYPE_RECORD_INDEX))
+#define GHWP_RECORD_INDEX_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GHWP_TYPE_RECORD_INDEX, GHWPRecordIndexClass))
+
+typedef struct _GHWPRecordIndexClass   GHWPRecordIndexClass;
+typedef struct _GHWPRecordIndexPrivate GHWPRecordIndexPrivate;
+typedef struct _GHWPPageMark           GHWPPageMark;
+
+/* 레코드 헤더만 디코딩한 결과 */
+struct _GHWPRecord
+{
+    guint16  tag_id;
+    guint16  level;
+    guint32  offset;    /* 섹션 안에서 레코드 헤더의 위치 */
+    guint32  data_len;
+};
+
+/* 페이지가 시작되는 줄 (v_pos 가 0 인 줄) */
+struct _GHWPPageMark
+{
+    guint32  paragraph; /* 섹션 안에서 level 0 문단의 번호 */
+    guint16  line_seg;  /* 0 이 아니면 문단 중간에서 페이지가 바뀐다 */
+    guint16  reserved;
+};
+
+struct _GHWPRecordIndex
+{
+    GObject                 parent_instance;
+    GHWPRecordIndexPrivate *priv;
+};
+
+struct _GHWPRecordIndexClass
+{
+    GObjectClass parent_class;
+};
+
+struct _GHWPRecordIndexPrivate
+{
+    GBytes             *records;     /* GHWPRecord 배열 */
+    GBytes             *paragraphs;  /* level 0 문단 헤더의 레코드 번호 */
+    GBytes             *page_marks;  /* GHWPPageMark 배열 */
+    const GHWPRecord   *record_data;
+    const guint32      *paragraph_data;
+    const GHWPPageMark *page_mark_data;
+    guint               n_records;
+    guint               n_paragraphs;
+    guint               n_page_marks;
+    gsize               section_size; /* 인덱스를 만든 섹션의 크기 */
+    ghwp_unit           page_h_size;  /* 마지막 PAGE_DEF 의 용지 크기 */
+    ghwp_unit           page_v_size;
+};
+
+GType               ghwp_record_index_get_type         (void) G_GNUC_CONST;
+GHWPRecordIndex    *ghwp_record_index_new              (GBytes          *section_data,
+                                                        GError         **error);
+guint               ghwp_record_index_get_n_records    (GHWPRecordIndex *index);
+const GHWPRecord   *ghwp_record_index_get_record       (GHWPRecordIndex *index,
+                                                        guint            i);
+guint               ghwp_record_index_get_n_paragraphs (GHWPRecordIndex *index);
+guint               ghwp_record_index_get_paragraph    (GHWPRecordIndex *index,
+                                                        guint            paragraph);
+guint               ghwp_record_index_get_n_page_marks (GHWPRecordIndex *index);
+const GHWPPageMark *ghwp_record_index_get_page_mark    (GHWPRecordIndex *index,
+                                                        guint            i);
+gint                ghwp_record_index_find             (GHWPRecordIndex *index,
+                                                        guint16          tag_id,
+                                                        guint            from);
+void                ghwp_record_index_get_page_size    (GHWPRecordIndex *index,
+                                                        ghwp_unit       *h_size,
+                                                        ghwp_unit       *v_size);
+
+G_END_DECLS
+
+#endif /* __GHWP_RECORD_INDEX_H__ */
@@ -0,0 +1,1039 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-search-index.c
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 문단 텍스트의 역색인. 한글은 이어지는 두 음절 (bigram) 을, 그 밖의
+ * 글자와 숫자는 공백 등으로 나뉜 단어를 검색어 조각으로 삼는다.
+ *
+ *   한글 bigram    (a * 11172 + b)             a, b 는 음절 번호
+ *   한글 끝 음절   0x08000000 | a              한글이 끝나는 마지막 음절
+ *   단어           0x80000000 | FNV-1a 해시    소문자로 바꾼 코드 포인트
+ *
+ * 한 음절로 찾을 때는 그 음절로 시작하는 bigram 들 (key 가 이어져 있다)
+ * 과 끝 음절을 합친다. 단어는 해시로만 저장하므로 드물게 다른 단어가
+ * 함께 찾아질 수 있다.
+ *
+ * 파일 형식은 캐시와 같이 그대로 mmap 해서 쓸 수 있다.
+ *
+ *   GHWPSearchIndexHeader
+ *   GHWPSearchTerm  x n_terms
+ *   GHWPSearchHit   x n_postings
+ */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <gio/gio.h>
+
+#include "ghwp-search-index.h"
+#include "ghwp-document.h"
+#include "ghwp-file-v5.h"
+#include "ghwp-parse.h"
+#include "ghwp-visitor.h"
+#include "ghwp-private.h"
+
+G_DEFINE_TYPE (GHWPSearchIndex, ghwp_search_index, G_TYPE_OBJECT);
+
+#define GHWP_SEARCH_INDEX_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), GHWP_TYPE_SEARCH_INDEX, GHWPSearchIndexPrivate))
+
+#define GHWP_SEARCH_INDEX_MAGIC       "GHWPSRC"
+#define GHWP_SEARCH_INDEX_VERSION     2
+#define GHWP_SEARCH_INDEX_BYTE_ORDER  0x01020304
+
+#define HANGUL_FIRST  0xac00
+#define HANGUL_LAST   0xd7a3
+#define HANGUL_COUNT  11172
+
+#define KEY_BIGRAM(a, b)  ((guint32) (a) * HANGUL_COUNT + (guint32) (b))
+#define KEY_UNIGRAM(a)    (0x08000000U | (guint32) (a))
+#define KEY_WORD(hash)    (0x80000000U | ((hash) & 0x7fffffffU))
+#define KEY_IS_WORD(key)  (((key) & 0x80000000U) != 0)
+
+#define FNV_OFFSET_BASIS  2166136261U
+#define FNV_PRIME         16777619U
+
+typedef struct _GHWPSearchIndexHeader GHWPSearchIndexHeader;
+
+struct _GHWPSearchIndexHeader
+{
+    gchar    magic[8];
+    guint32  byte_order;
+    guint32  version;
+    guint32  n_terms;
+    guint32  n_postings;
+};
+
+/** 글자를 조각으로 나누기 ***************************************************/
+
+typedef enum
+{
+    TOKEN_NONE,
+    TOKEN_HANGUL,
+    TOKEN_WORD
+} TokenKind;
+
+typedef struct
+{
+    guint8   kind;
+    guint32  start;     /* 단어가 시작한 위치 */
+    guint32  prev;      /* 한글: 앞 음절 번호 */
+    guint32  prev_pos;  /* 한글: 앞 음절의 위치 */
+    guint32  hash;      /* 단어: 지금까지의 해시 */
+} Tokenizer;
+
+typedef void (*TokenFunc) (guint32 key, guint32 offset, gpointer user_data);
+
+static void tokenizer_flush (Tokenizer *t, TokenFunc func, gpointer user_data)
+{
+    if (t->kind == TOKEN_HANGUL)
+        func (KEY_UNIGRAM (t->prev), t->prev_pos, user_data);
+    else if (t->kind == TOKEN_WORD)
+        func (KEY_WORD (t->hash), t->start, user_data);
+
+    t->kind = TOKEN_NONE;
+}
+
+static void tokenizer_feed (Tokenizer *t,
+                            gunichar   c,
+                            guint32    pos,
+                            TokenFunc  func,
+                            gpointer   user_data)
+{
+    if (c >= HANGUL_FIRST && c <= HANGUL_LAST) {
+        guint32 syllable = c - HANGUL_FIRST;
+
+        if (t->kind == TOKEN_HANGUL) {
+            func (KEY_BIGRAM (t->prev, syllable), t->prev_pos, user_data);
+        } else {
+            tokenizer_flush (t, func, user_data);
+            t->kind = TOKEN_HANGUL;
+        }
+        t->prev     = syllable;
+        t->prev_pos = pos;
+    } else if (g_unichar_isalnum (c)) {
+        if (t->kind != TOKEN_WORD) {
+            tokenizer_flush (t, func, user_data);
+            t->kind  = TOKEN_WORD;
+            t->start = pos;
+            t->hash  = FNV_OFFSET_BASIS;
+        }
+        t->hash = (t->hash ^ g_unichar_tolower (c)) * FNV_PRIME;
+    } else {
+        tokenizer_flush (t, func, user_data);
+    }
+}
+
+/* UTF-16 글자들을 넣고 넣은 글자 수를 돌려준다. 위치는 ghwp_text_get_text ()
+ * 에서처럼 글자 단위로 센다. 대리 쌍은 한 글자, 짝이 없는 대리 단위도
+ * U+FFFD 한 글자이다. */
+static guint32 tokenizer_feed_utf16 (Tokenizer       *t,
+                                     const gunichar2 *units,
+                                     guint            n_units,
+                                     guint32          pos,
+                                     TokenFunc        func,
+                                     gpointer         user_data)
+{
+    guint32 n = 0;
+    guint   i;
+
+    for (i = 0; i < n_units; i++) {
+        gunichar c = units[i];
+
+        if (c >= 0xd800 && c <= 0xdbff && i + 1 < n_units &&
+            units[i + 1] >= 0xdc00 && units[i + 1] <= 0xdfff) {
+            c = 0x10000 + ((c - 0xd800) << 10) + (units[i + 1] - 0xdc00);
+            i++;
+        } else if (c >= 0xd800 && c <= 0xdfff) {
+            c = 0xfffd;
+        }
+
+        tokenizer_feed (t, c, pos + n++, func, user_data);
+    }
+
+    return n;
+}
+
+/** 색인 만들기 **************************************************************/
+
+typedef struct
+{
+    guint32  key;
+    GHWPSearchHit hit;
+} Posting;
+
+/* 열려 있는 문단 */
+typedef struct
+{
+    guint32   paragraph;       /* 본문 문단의 번호 */
+    guint32   cell;            /* 본문 문단의 표에서 셀의 번호 */
+    guint32   cell_paragraph;  /* 셀 안에서 문단의 번호 */
+    guint32   pos;             /* 다음 text_run 의 위치 (글자) */
+    gboolean  indexed;         /* 문서 모델에 있는 문단만 색인한다 */
+    gboolean  has_table;       /* 본문 문단: 표를 이미 만났다 */
+    guint     table_mark;      /* 본문 문단: 첫 표를 만났을 때의 postings 수 */
+    Tokenizer tokenizer;
+} BuilderItem;
+
+typedef struct
+{
+    GArray       *postings;  /* Posting 배열 */
+    GCancellable *cancellable;
+    GError       *error;
+    guint32       section;
+    guint32       n_paragraphs;       /* 섹션의 본문 문단 수 */
+    guint         table_depth;        /* 열려 있는 표의 깊이 */
+    gboolean      in_body_table;      /* 가장 바깥 표가 본문 문단의 표이다 */
+    guint32       table_paragraph;    /* 그 표가 있는 본문 문단의 번호 */
+    guint32       n_cells;            /* 그 표에서 지금까지 나온 셀 수 */
+    guint32       n_cell_paragraphs;  /* 지금 셀에서 나온 문단 수 */
+    gunichar2    *units;
+    guint         n_units;
+    guint         depth;
+    BuilderItem   stack[GHWP_MAX_STATE * 2];
+} GHWPSearchIndexBuilder;
+
+static void builder_add (guint32 key, guint32 offset, gpointer user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+    BuilderItem            *item = &builder->stack[builder->depth - 1];
+    Posting                 posting;
+
+    if (!item->indexed)
+        return;
+
+    posting.key                = key;
+    posting.hit.section        = builder->section;
+    posting.hit.paragraph      = item->paragraph;
+    posting.hit.cell           = item->cell;
+    posting.hit.cell_paragraph = item->cell_paragraph;
+    posting.hit.offset         = offset;
+
+    g_array_append_val (builder->postings, posting);
+}
+
+static gboolean builder_section_begin (guint index, gpointer user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+
+    builder->section       = index;
+    builder->n_paragraphs  = 0;
+    builder->table_depth   = 0;
+    builder->in_body_table = FALSE;
+    builder->depth         = 0;
+
+    return TRUE;
+}
+
+static gboolean builder_paragraph_begin (const GHWPParagraphHeader *header,
+                                         GHWPScope                  scope,
+                                         guint                      level,
+                                         gpointer                   user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+    BuilderItem            *item;
+
+    g_return_val_if_fail (builder->depth < G_N_ELEMENTS (builder->stack),
+                          FALSE);
+
+    item = &builder->stack[builder->depth++];
+    item->pos            = 0;
+    item->has_table      = FALSE;
+    item->tokenizer.kind = TOKEN_NONE;
+
+    /* 문서 모델처럼 본문 문단과 그 표의 셀 문단만 번호를 매긴다 */
+    if (scope == GHWP_SCOPE_BODY) {
+        item->paragraph      = builder->n_paragraphs++;
+        item->cell           = GHWP_SEARCH_HIT_NO_CELL;
+        item->cell_paragraph = 0;
+        item->indexed        = TRUE;
+    } else if (scope == GHWP_SCOPE_CELL && builder->table_depth == 1 &&
+               builder->in_body_table && builder->n_cells > 0) {
+        item->paragraph      = builder->table_paragraph;
+        item->cell           = builder->n_cells - 1;
+        item->cell_paragraph = builder->n_cell_paragraphs++;
+        item->indexed        = TRUE;
+    } else {
+        item->indexed        = FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean builder_paragraph_end (gpointer user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+
+    if (builder->depth == 0)
+        return TRUE;
+
+    tokenizer_flush (&builder->stack[builder->depth - 1].tokenizer,
+                     builder_add, builder);
+    builder->depth--;
+
+    return !g_cancellable_set_error_if_cancelled (builder->cancellable,
+                                                  &builder->error);
+}
+
+static gboolean builder_text_run (const guint8 *utf16le,
+                                  guint         n_chars,
+                                  gpointer      user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+    BuilderItem            *item;
+    guint                   i;
+
+    if (builder->depth == 0)
+        return TRUE;
+
+    item = &builder->stack[builder->depth - 1];
+    if (!item->indexed)
+        return TRUE;
+
+    if (n_chars > builder->n_units) {
+        builder->units   = g_renew (gunichar2, builder->units, n_chars);
+        builder->n_units = n_chars;
+    }
+    for (i = 0; i < n_chars; i++)
+        builder->units[i] = utf16le[i * 2] | (utf16le[i * 2 + 1] << 8);
+
+    item->pos += tokenizer_feed_utf16 (&item->tokenizer, builder->units,
+                                       n_chars, item->pos, builder_add,
+                                       builder);
+
+    return TRUE;
+}
+
+static gboolean builder_control (gunichar2 code,
+                                 guint32   ctrl_id,
+                                 guint     position,
+                                 gpointer  user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+    BuilderItem            *item;
+
+    if (builder->depth == 0)
+        return TRUE;
+
+    /* 제어 문자는 조각을 나눈다. ghwp_text_get_text () 에는 문자 제어
+     * 문자만 한 글자로 남는다. */
+    item = &builder->stack[builder->depth - 1];
+    tokenizer_flush (&item->tokenizer, builder_add, builder);
+
+    if (code < GHWP_NUM_CC && ghwp_control_char_type[code] == GHWP_CC_TYPE_CHAR)
+        item->pos++;
+
+    return TRUE;
+}
+
+static gboolean builder_table_begin (guint16  n_rows,
+                                     guint16  n_cols,
+                                     gpointer user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+    BuilderItem            *item;
+
+    if (builder->table_depth++ > 0)
+        return TRUE;
+
+    item = builder->depth > 0 ? &builder->stack[builder->depth - 1] : NULL;
+    builder->in_body_table = item && item->indexed &&
+                             item->cell == GHWP_SEARCH_HIT_NO_CELL;
+    if (!builder->in_body_table)
+        return TRUE;
+
+    tokenizer_flush (&item->tokenizer, builder_add, builder);
+
+    /* 문서 모델의 문단은 마지막 표만 가지므로 앞 표의 셀은 버린다 */
+    if (item->has_table) {
+        g_array_set_size (builder->postings, item->table_mark);
+    } else {
+        item->has_table  = TRUE;
+        item->table_mark = builder->postings->len;
+    }
+
+    builder->table_paragraph = item->paragraph;
+    builder->n_cells         = 0;
+
+    return TRUE;
+}
+
+static gboolean builder_table_cell (guint16  row,
+                                    guint16  col,
+                                    guint16  row_span,
+                                    guint16  col_span,
+                                    gpointer user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+
+    if (builder->table_depth == 1 && builder->in_body_table) {
+        builder->n_cells++;
+        builder->n_cell_paragraphs = 0;
+    }
+
+    return TRUE;
+}
+
+static gboolean builder_table_end (gpointer user_data)
+{
+    GHWPSearchIndexBuilder *builder = user_data;
+
+    if (builder->table_depth > 0 && --builder->table_depth == 0)
+        builder->in_body_table = FALSE;
+
+    return TRUE;
+}
+
+static const GHWPVisitor search_index_visitor = {
+    builder_section_begin,
+    NULL,                    /* section_end */
+    builder_paragraph_begin,
+    builder_paragraph_end,
+    builder_text_run,
+    builder_control,
+    builder_table_begin,
+    builder_table_cell,
+    builder_table_end,
+    NULL                     /* picture */
+};
+
+/* v3, HWPML 문서는 문단을 모두 읽어 두므로 그 텍스트로 만든다 */
+static gboolean builder_add_paragraphs (GHWPSearchIndexBuilder *builder,
+                                        GHWPDocument           *doc)
+{
+    guint i;
+
+    builder_section_begin (0, builder);
+
+    for (i = 0; i < doc->paragraphs->len; i++) {
+        GHWPParagraph *paragraph;
+        BuilderItem   *item;
+        const gchar   *p = NULL;
+
+        paragraph = g_array_index (doc->paragraphs, GHWPParagraph *, i);
+        if (paragraph->ghwp_text)
+            p = ghwp_text_get_text (paragraph->ghwp_text);
+
+        builder_paragraph_begin (NULL, GHWP_SCOPE_BODY, 0, builder);
+        item = &builder->stack[0];
+
+        for (; p && *p; p = g_utf8_next_char (p)) {
+            gunichar c = g_utf8_get_char (p);
+
+            tokenizer_feed (&item->tokenizer, c, item->pos++, builder_add,
+                            builder);
+        }
+
+        if (!builder_paragraph_end (builder))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* 같은 문단이면 0 */
+static gint hit_compare_paragraph (const GHWPSearchHit *ha,
+                                   const GHWPSearchHit *hb)
+{
+    if (ha->section != hb->section)
+        return ha->section < hb->section ? -1 : 1;
+    if (ha->paragraph != hb->paragraph)
+        return ha->paragraph < hb->paragraph ? -1 : 1;
+    if (ha->cell != hb->cell)
+        return ha->cell < hb->cell ? -1 : 1;
+    if (ha->cell_paragraph != hb->cell_paragraph)
+        return ha->cell_paragraph < hb->cell_paragraph ? -1 : 1;
+    return 0;
+}
+
+static gint hit_compare (gconstpointer a, gconstpointer b)
+{
+    const GHWPSearchHit *ha = a;
+    const GHWPSearchHit *hb = b;
+    gint                 cmp = hit_compare_paragraph (ha, hb);
+
+    if (cmp != 0)
+        return cmp;
+    if (ha->offset != hb->offset)
+        return ha->offset < hb->offset ? -1 : 1;
+    return 0;
+}
+
+static gint posting_compare (gconstpointer a, gconstpointer b)
+{
+    const Posting *pa = a;
+    const Posting *pb = b;
+
+    if (pa->key != pb->key)
+        return pa->key < pb->key ? -1 : 1;
+    return hit_compare (&pa->hit, &pb->hit);
+}
+
+static void ghwp_search_index_set_tables (GHWPSearchIndex *index,
+                                          GBytes          *terms,
+                                          GBytes          *postings)
+{
+    GHWPSearchIndexPrivate *priv = index->priv;
+    gsize                   size;
+
+    priv->terms        = terms;
+    priv->postings     = postings;
+    priv->term_data    = g_bytes_get_data (terms, &size);
+    priv->n_terms      = size / sizeof (GHWPSearchTerm);
+    priv->posting_data = g_bytes_get_data (postings, &size);
+    priv->n_postings   = size / sizeof (GHWPSearchHit);
+}
+
+/**
+ * ghwp_search_index_new_for_document:
+ * @doc: a #GHWPDocument
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Builds a full-text index of the paragraphs of @doc. For HWP v5
+ * documents the text is read straight from the body records without
+ * building pages. The hits point into the document model, see
+ * #GHWPSearchHit for what is indexed.
+ *
+ * Returns: (transfer full): a new #GHWPSearchIndex, or %NULL on error
+ */
+GHWPSearchIndex *ghwp_search_index_new_for_document (GHWPDocument  *doc,
+                                                     GCancellable  *cancellable,
+                                                     GError       **error)
+{
+    GHWPSearchIndexBuilder *builder;
+    GHWPSearchIndex        *index = NULL;
+    GHWPSearchTerm         *terms;
+    GHWPSearchHit          *hits;
+    guint                   n_terms = 0;
+    gboolean                ok;
+    guint                   i;
+
+    g_return_val_if_fail (GHWP_IS_DOCUMENT (doc), NULL);
+
+    builder = g_new0 (GHWPSearchIndexBuilder, 1);
+    builder->postings    = g_array_new (FALSE, FALSE, sizeof (Posting));
+    builder->cancellable = cancellable;
+
+    if (GHWP_IS_FILE_V5 (doc->file))
+        ok = ghwp_document_walk (doc, &search_index_visitor, builder, error);
+    else
+        ok = builder_add_paragraphs (builder, doc);
+
+    if (builder->error) {
+        g_propagate_error (error, builder->error);
+        ok = FALSE;
+    }
+
+    if (ok) {
+        Posting *postings = (Posting *) builder->postings->data;
+        guint    n_postings = builder->postings->len;
+
+        /* 조각 순서로, 같은 조각은 위치 순서로 */
+        g_array_sort (builder->postings, posting_compare);
+
+        for (i = 0; i < n_postings; i++) {
+            if (i == 0 || postings[i].key != postings[i - 1].key)
+                n_terms++;
+        }
+
+        terms = g_new (GHWPSearchTerm, n_terms);
+        hits  = g_new (GHWPSearchHit, n_postings);
+        n_terms = 0;
+
+        for (i = 0; i < n_postings; i++) {
+            if (i == 0 || postings[i].key != postings[i - 1].key) {
+                terms[n_terms].key   = postings[i].key;
+                terms[n_terms].first = i;
+                n_terms++;
+            }
+            hits[i] = postings[i].hit;
+        }
+
+        index = g_object_new (GHWP_TYPE_SEARCH_INDEX, NULL);
+        ghwp_search_index_set_tables (index,
+            g_bytes_new_take (terms, n_terms * sizeof (GHWPSearchTerm)),
+            g_bytes_new_take (hits, n_postings * sizeof (GHWPSearchHit)));
+    }
+
+    g_array_free (builder->postings, TRUE);
+    g_free (builder->units);
+    g_free (builder);
+
+    return index;
+}
+
+/** 저장과 읽기 ***************************************************************/
+
+/**
+ * ghwp_search_index_new_from_path:
+ * @path: a file written by ghwp_search_index_save()
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Maps an index saved by ghwp_search_index_save(). Nothing is copied.
+ *
+ * Returns: (transfer full): a #GHWPSearchIndex, or %NULL on error
+ */
+GHWPSearchIndex *ghwp_search_index_new_from_path (const gchar *path,
+                                                  GError     **error)
+{
+    GMappedFile                 *mapped;
+    GBytes                      *bytes;
+    const GHWPSearchIndexHeader *header;
+    const guint8                *data;
+    gsize                        size;
+    gsize                        terms_size;
+    gsize                        postings_size;
+    GHWPSearchIndex             *index;
+    guint                        i;
+
+    g_return_val_if_fail (path != NULL, NULL);
+
+    mapped = g_mapped_file_new (path, FALSE, error);
+    if (mapped == NULL)
+        return NULL;
+
+    bytes = g_mapped_file_get_bytes (mapped);
+    g_mapped_file_unref (mapped);
+    data  = g_bytes_get_data (bytes, &size);
+
+    header = (const GHWPSearchIndexHeader *) data;
+
+    if (size < sizeof (GHWPSearchIndexHeader) ||
+        memcmp (header->magic, GHWP_SEARCH_INDEX_MAGIC,
+                sizeof (header->magic)) != 0 ||
+        header->byte_order != GHWP_SEARCH_INDEX_BYTE_ORDER ||
+        header->version    != GHWP_SEARCH_INDEX_VERSION)
+        goto invalid;
+
+    terms_size    = (gsize) header->n_terms * sizeof (GHWPSearchTerm);
+    postings_size = (gsize) header->n_postings * sizeof (GHWPSearchHit);
+
+    if (size - sizeof (GHWPSearchIndexHeader) < terms_size ||
+        size - sizeof (GHWPSearchIndexHeader) - terms_size < postings_size)
+        goto invalid;
+
+    index = g_object_new (GHWP_TYPE_SEARCH_INDEX, NULL);
+    ghwp_search_index_set_tables (index,
+        g_bytes_new_from_bytes (bytes, sizeof (GHWPSearchIndexHeader),
+                                terms_size),
+        g_bytes_new_from_bytes (bytes,
+                                sizeof (GHWPSearchIndexHeader) + terms_size,
+                                postings_size));
+    g_bytes_unref (bytes);
+
+    /* 조각의 위치가 범위를 벗어나지 않는지 본다 */
+    for (i = 0; i < index->priv->n_terms; i++) {
+        if (index->priv->term_data[i].first >= index->priv->n_postings ||
+            (i > 0 && (index->priv->term_data[i].key <=
+                       index->priv->term_data[i - 1].key ||
+                       index->priv->term_data[i].first <=
+                       index->priv->term_data[i - 1].first))) {
+            g_object_unref (index);
+            g_set_error (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                         "Invalid search index: %s", path);
+            return NULL;
+        }
+    }
+
+    return index;
+
+invalid:
+    g_bytes_unref (bytes);
+    g_set_error (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                 "Invalid search index: %s", path);
+    return NULL;
+}
+
+/**
+ * ghwp_search_index_save:
+ * @index: a #GHWPSearchIndex
+ * @path: where to write the index, e.g. next to the document
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Writes @index to @path so that it can be mapped again with
+ * ghwp_search_index_new_from_path(). The file is replaced atomically.
+ * It uses the byte order of the host.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean ghwp_search_index_save (GHWPSearchIndex *index,
+                                 const gchar     *path,
+                                 GError         **error)
+{
+    GHWPSearchIndexHeader  header;
+    GFile                 *file;
+    GFileOutputStream     *stream;
+    GOutputStream         *out;
+    gboolean               is_success;
+
+    g_return_val_if_fail (GHWP_IS_SEARCH_INDEX (index), FALSE);
+    g_return_val_if_fail (path != NULL, FALSE);
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, GHWP_SEARCH_INDEX_MAGIC, sizeof (header.magic));
+    header.byte_order = GHWP_SEARCH_INDEX_BYTE_ORDER;
+    header.version    = GHWP_SEARCH_INDEX_VERSION;
+    header.n_terms    = index->priv->n_terms;
+    header.n_postings = index->priv->n_postings;
+
+    file   = g_file_new_for_path (path);
+    stream = g_file_replace (file, NULL, FALSE,
+                             G_FILE_CREATE_REPLACE_DESTINATION, NULL, error);
+    g_object_unref (file);
+
+    if (stream == NULL)
+        return FALSE;
+
+    out = G_OUTPUT_STREAM (stream);
+
+    is_success =
+        g_output_stream_write_all (out, &header, sizeof (header),
+                                   NULL, NULL, error) &&
+        g_output_stream_write_all (out, index->priv->term_data,
+                                   index->priv->n_terms * sizeof (GHWPSearchTerm),
+                                   NULL, NULL, error) &&
+        g_output_stream_write_all (out, index->priv->posting_data,
+                                   index->priv->n_postings * sizeof (GHWPSearchHit),
+                                   NULL, NULL, error);
+
+    /* 실패하면 닫기 전에 취소해서 원래 파일을 남겨 둔다 */
+    if (is_success) {
+        is_success = g_output_stream_close (out, NULL, error);
+    } else {
+        GCancellable *cancellable = g_cancellable_new ();
+        g_cancellable_cancel (cancellable);
+        g_output_stream_close (out, cancellable, NULL);
+        g_object_unref (cancellable);
+    }
+
+    g_object_unref (stream);
+    return is_success;
+}
+
+/** 찾기 *********************************************************************/
+
+/* key 가 같거나 큰 첫 조각의 번호 */
+static guint index_lower_bound (GHWPSearchIndex *index, guint32 key)
+{
+    const GHWPSearchTerm *terms = index->priv->term_data;
+    guint                 lo = 0;
+    guint                 hi = index->priv->n_terms;
+
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+
+        if (terms[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* 조각 [from, to) 의 위치들이 postings 에서 차지하는 범위 */
+static void index_get_postings (GHWPSearchIndex *index,
+                                guint            from,
+                                guint            to,
+                                guint           *first,
+                                guint           *last)
+{
+    GHWPSearchIndexPrivate *priv = index->priv;
+
+    *first = from < priv->n_terms ? priv->term_data[from].first
+                                  : priv->n_postings;
+    *last  = to   < priv->n_terms ? priv->term_data[to].first
+                                  : priv->n_postings;
+}
+
+/* key 조각의 위치들, 없으면 빈 범위 */
+static void index_find_term (GHWPSearchIndex *index,
+                             guint32          key,
+                             guint           *first,
+                             guint           *last)
+{
+    guint i = index_lower_bound (index, key);
+
+    if (i < index->priv->n_terms && index->priv->term_data[i].key == key)
+        index_get_postings (index, i, i + 1, first, last);
+    else
+        *first = *last = 0;
+}
+
+static gboolean hits_contain (const GHWPSearchHit *hits,
+                              guint                first,
+                              guint                last,
+                              const GHWPSearchHit *hit)
+{
+    return bsearch (hit, hits + first, last - first, sizeof (GHWPSearchHit),
+                    hit_compare) != NULL;
+}
+
+/* hit 와 같은 문단에 조각이 하나라도 있는가 */
+static gboolean hits_contain_paragraph (const GHWPSearchHit *hits,
+                                        guint                n_hits,
+                                        const GHWPSearchHit *hit)
+{
+    guint lo = 0;
+    guint hi = n_hits;
+
+    while (lo < hi) {
+        guint mid = (lo + hi) / 2;
+
+        if (hit_compare_paragraph (&hits[mid], hit) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < n_hits && hit_compare_paragraph (&hits[lo], hit) == 0;
+}
+
+typedef struct
+{
+    GArray *keys;     /* 검색어의 조각들 (guint32) */
+    GArray *offsets;  /* 검색어 안에서 조각의 위치 (guint32) */
+} QueryTokens;
+
+static void query_add (guint32 key, guint32 offset, gpointer user_data)
+{
+    QueryTokens *tokens = user_data;
+
+    g_array_append_val (tokens->keys, key);
+    g_array_append_val (tokens->offsets, offset);
+}
+
+/*
+ * 검색어의 한 부분 (한글 한 덩어리 또는 단어 하나) 이 나오는 위치들.
+ * keys 는 한글이면 bigram 들과 끝 음절, 단어이면 단어 하나이다.
+ */
+static GArray *index_find_part (GHWPSearchIndex *index,
+                                const guint32   *keys,
+                                const guint32   *offsets,
+                                guint            n_keys)
+{
+    const GHWPSearchHit *hits = index->priv->posting_data;
+    GArray              *result;
+    guint                first, last;
+    guint                i, k;
+
+    result = g_array_new (FALSE, FALSE, sizeof (GHWPSearchHit));
+
+    if (n_keys == 1 && !KEY_IS_WORD (keys[0])) {
+        /* 한 음절: 그 음절로 시작하는 bigram 들과 끝 음절 */
+        guint32 a = keys[0] & ~0x08000000U;
+        guint   from = index_lower_bound (index, KEY_BIGRAM (a, 0));
+        guint   to   = index_lower_bound (index, KEY_BIGRAM (a + 1, 0));
+
+        index_get_postings (index, from, to, &first, &last);
+        g_array_append_vals (result, hits + first, last - first);
+
+        index_find_term (index, keys[0], &first, &last);
+        g_array_append_vals (result, hits + first, last - first);
+
+        g_array_sort (result, hit_compare);
+        return result;
+    }
+
+    /* 단어이거나 여러 음절이면 첫 조각에서 시작해 나머지 bigram 이
+     * 이어서 나오는지 본다. 끝 음절은 더 긴 낱말의 중간일 수 있으므로
+     * 보지 않는다. */
+    index_find_term (index, keys[0], &first, &last);
+
+    for (i = first; i < last; i++) {
+        gboolean found = TRUE;
+
+        for (k = 1; found && k < n_keys; k++) {
+            GHWPSearchHit hit = hits[i];
+            guint         f, l;
+
+            if (!KEY_IS_WORD (keys[k]) && keys[k] >= KEY_UNIGRAM (0))
+                continue;
+
+            hit.offset += offsets[k] - offsets[0];
+            index_find_term (index, keys[k], &f, &l);
+            found = hits_contain (hits, f, l, &hit);
+        }
+
+        if (found)
+            g_array_append_val (result, hits[i]);
+    }
+
+    return result;
+}
+
+/**
+ * ghwp_search_index_lookup:
+ * @index: a #GHWPSearchIndex
+ * @query: UTF-8 text to look for
+ *
+ * Looks up @query in @index. The query is split into Hangul runs and
+ * words in the same way as the text was. Each Hangul run is matched
+ * anywhere in a word, words are matched whole and case-insensitively,
+ * and all parts of the query must be in the same paragraph.
+ *
+ * Returns: (transfer full) (element-type GHWPSearchHit): the positions
+ * where the first part of @query was found, in document order
+ */
+GArray *ghwp_search_index_lookup (GHWPSearchIndex *index, const gchar *query)
+{
+    QueryTokens  tokens;
+    Tokenizer    tokenizer = { TOKEN_NONE, };
+    GPtrArray   *parts;
+    GArray      *result = NULL;
+    const gchar *p;
+    guint32      pos = 0;
+    guint        start, i, k;
+
+    g_return_val_if_fail (GHWP_IS_SEARCH_INDEX (index), NULL);
+    g_return_val_if_fail (query != NULL, NULL);
+
+    tokens.keys    = g_array_new (FALSE, FALSE, sizeof (guint32));
+    tokens.offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+    for (p = query; *p; p = g_utf8_next_char (p)) {
+        gunichar c = g_utf8_get_char (p);
+
+        tokenizer_feed (&tokenizer, c, pos++, query_add, &tokens);
+    }
+    tokenizer_flush (&tokenizer, query_add, &tokens);
+
+    /* 한글 덩어리는 끝 음절에서, 단어는 그 자리에서 끝난다 */
+    parts = g_ptr_array_new_with_free_func ((GDestroyNotify) g_array_unref);
+    start = 0;
+    for (i = 0; i < tokens.keys->len; i++) {
+        guint32 key = g_array_index (tokens.keys, guint32, i);
+
+        if (KEY_IS_WORD (key) || key >= KEY_UNIGRAM (0)) {
+            g_ptr_array_add (parts, index_find_part (index,
+                &g_array_index (tokens.keys, guint32, start),
+                &g_array_index (tokens.offsets, guint32, start),
+                i + 1 - start));
+            start = i + 1;
+        }
+    }
+
+    if (parts->len > 0) {
+        GArray *first = g_ptr_array_index (parts, 0);
+
+        result = g_array_new (FALSE, FALSE, sizeof (GHWPSearchHit));
+
+        for (i = 0; i < first->len; i++) {
+            const GHWPSearchHit *hit = &g_array_index (first, GHWPSearchHit, i);
+            gboolean             found = TRUE;
+
+            for (k = 1; found && k < parts->len; k++) {
+                GArray *part = g_ptr_array_index (parts, k);
+
+                found = hits_contain_paragraph ((GHWPSearchHit *) part->data,
+                                                part->len, hit);
+            }
+
+            if (found)
+                g_array_append_val (result, *hit);
+        }
+    } else {
+        result = g_array_new (FALSE, FALSE, sizeof (GHWPSearchHit));
+    }
+
+    g_ptr_array_unref (parts);
+    g_array_free (tokens.keys, TRUE);
+    g_array_free (tokens.offsets, TRUE);
+
+    return result;
+}
+
+/**
+ * ghwp_document_search_index:
+ * @doc: a #GHWPDocument
+ * @query: UTF-8 text to look for
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Looks up @query in the full-text index of @doc, see
+ * ghwp_search_index_lookup(). The index is built on the first call and
+ * kept with @doc. If the on-disk cache was enabled with
+ * %GHWP_CACHE_SEARCH_INDEX, the index is read from and saved to the
+ * cache, so later searches in the same file do not read its text again.
+ *
+ * Returns: (transfer full) (element-type GHWPSearchHit): the positions
+ * found, or %NULL on error
+ */
+GArray *ghwp_document_search_index (GHWPDocument *doc,
+                                    const gchar  *query,
+                                    GError      **error)
+{
+    GHWPSearchIndex *index;
+    gchar           *path = NULL;
+
+    g_return_val_if_fail (GHWP_IS_DOCUMENT (doc), NULL);
+    g_return_val_if_fail (query != NULL, NULL);
+
+    index = _ghwp_document_get_search_index (doc);
+
+    if (index == NULL) {
+        if (GHWP_IS_FILE_V5 (doc->file))
+            path = _ghwp_cache_get_search_index_path (
+                       GHWP_FILE_V5 (doc->file)->priv->cache_path);
+
+        if (path)
+            index = ghwp_search_index_new_from_path (path, NULL);
+
+        if (index == NULL) {
+            index = ghwp_search_index_new_for_document (doc, NULL, error);
+            if (index == NULL) {
+                g_free (path);
+                return NULL;
+            }
+
+            /* 캐시에 쓰지 못해도 찾을 수는 있다 */
+            if (path)
+                ghwp_search_index_save (index, path, NULL);
+        }
+
+        g_free (path);
+        _ghwp_document_set_search_index (doc, index);
+    }
+
+    return ghwp_search_index_lookup (index, query);
+}
+
+static void ghwp_search_index_finalize (GObject *obj)
+{
+    GHWPSearchIndex *index = GHWP_SEARCH_INDEX (obj);
+
+    if (index->priv->terms)
+        g_bytes_unref (index->priv->terms);
+    if (index->priv->postings)
+        g_bytes_unref (index->priv->postings);
+
+    G_OBJECT_CLASS (ghwp_search_index_parent_class)->finalize (obj);
+}
+
+static void ghwp_search_index_class_init (GHWPSearchIndexClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    g_type_class_add_private (klass, sizeof (GHWPSearchIndexPrivate));
+    object_class->finalize = ghwp_search_index_finalize;
+}
+
+static void ghwp_search_index_init (GHWPSearchIndex *index)
+{
+    index->priv = GHWP_SEARCH_INDEX_GET_PRIVATE (index);
+}
@@ -0,0 +1,125 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-search-index.h
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
+ */
+
+#ifndef __GHWP_SEARCH_INDEX_H__
+#define __GHWP_SEARCH_INDEX_H__
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "ghwp.h"
+
+G_BEGIN_DECLS
+
+#define GHWP_TYPE_SEARCH_INDEX             (ghwp_search_index_get_type ())
+#define GHWP_SEARCH_INDEX(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GHWP_TYPE_SEARCH_INDEX, GHWPSearchIndex))
+#define GHWP_SEARCH_INDEX_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GHWP_TYPE_SEARCH_INDEX, GHWPSearchIndexClass))
+#define GHWP_IS_SEARCH_INDEX(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GHWP_TYPE_SEARCH_INDEX))
+#define GHWP_IS_SEARCH_INDEX_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GHWP_TYPE_SEARCH_INDEX))
+#define GHWP_SEARCH_INDEX_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GHWP_TYPE_SEARCH_INDEX, GHWPSearchIndexClass))
+
+typedef struct _GHWPSearchIndexClass   GHWPSearchIndexClass;
+typedef struct _GHWPSearchIndexPrivate GHWPSearchIndexPrivate;
+typedef struct _GHWPSearchTerm         GHWPSearchTerm;
+typedef struct _GHWPSearchHit          GHWPSearchHit;
+
+/* 검색어 조각 하나, 그 위치들은 postings[first] 부터 다음 조각의 first 앞까지 */
+struct _GHWPSearchTerm
+{
+    guint32  key;
+    guint32  first;
+};
+
+/* 표의 셀 안이 아닌 위치의 GHWPSearchHit.cell */
+#define GHWP_SEARCH_HIT_NO_CELL  G_MAXUINT32
+
+/**
+ * GHWPSearchHit:
+ * @section: index in #GHWPDocument.sections, always 0 for HWP v3 and
+ *     HWPML documents
+ * @paragraph: index of the top-level paragraph in #GHWPSection.paragraphs,
+ *     or in #GHWPDocument.paragraphs for HWP v3 and HWPML documents
+ * @cell: index in the #GHWPTable.cells of the paragraph's table when the
+ *     text is in a table cell, or %GHWP_SEARCH_HIT_NO_CELL
+ * @cell_paragraph: index in #GHWPTableCell.paragraphs of that cell, 0 if
+ *     @cell is %GHWP_SEARCH_HIT_NO_CELL
+ * @offset: position in characters (not bytes) in the ghwp_text_get_text()
+ *     of the paragraph, as counted by g_utf8_pointer_to_offset()
+ *
+ * The position of a hit in the paragraph model. Section paragraphs of an
+ * HWP v5 document are built when one of the section's pages is got with
+ * ghwp_document_get_page().
+ *
+ * Only the text that the model keeps is indexed: top-level paragraphs and
+ * the cells of their tables. Text in table captions, headers, footers,
+ * notes, text boxes and tables inside cells is not.
+ */
+struct _GHWPSearchHit
+{
+    guint32  section;
+    guint32  paragraph;
+    guint32  cell;
+    guint32  cell_paragraph;
+    guint32  offset;
+};
+
+struct _GHWPSearchIndex
+{
+    GObject                 parent_instance;
+    GHWPSearchIndexPrivate *priv;
+};
+
+struct _GHWPSearchIndexClass
+{
+    GObjectClass parent_class;
+};
+
+struct _GHWPSearchIndexPrivate
+{
+    GBytes               *terms;     /* GHWPSearchTerm 배열, key 순서 */
+    GBytes               *postings;  /* GHWPSearchHit 배열, 조각마다 위치 순서 */
+    const GHWPSearchTerm *term_data;
+    const GHWPSearchHit  *posting_data;
+    guint                 n_terms;
+    guint                 n_postings;
+};
+
+GType            ghwp_search_index_get_type         (void) G_GNUC_CONST;
+GHWPSearchIndex *ghwp_search_index_new_for_document (GHWPDocument    *doc,
+                                                     GCancellable    *cancellable,
+                                                     GError         **error);
+GHWPSearchIndex *ghwp_search_index_new_from_path    (const gchar     *path,
+                                                     GError         **error);
+gboolean         ghwp_search_index_save             (GHWPSearchIndex *index,
+                                                     const gchar     *path,
+                                                     GError         **error);
+GArray          *ghwp_search_index_lookup           (GHWPSearchIndex *index,
+                                                     const gchar     *query);
+GArray          *ghwp_document_search_index         (GHWPDocument    *doc,
+                                                     const gchar     *query,
+                                                     GError         **error);
+
+G_END_DECLS
+
+#endif /* __GHWP_SEARCH_INDEX_H__ */
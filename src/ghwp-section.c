@@ -46,39 +46,57 @@ static void ghwp_section_init (GHWPSection *sec)
     sec->paragraphs = g_array_new (FALSE, FALSE, sizeof (GHWPParagraph *));
 }
 
+static const GHWPField section_def_fields[] = {
+    GHWP_FIELD (GHWPSectionDef, attr,              GHWP_U32),
+    GHWP_FIELD (GHWPSectionDef, col_spacing,       GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, v_align,           GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, h_align,           GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, default_tab_size,  GHWP_U32),
+    GHWP_FIELD (GHWPSectionDef, num_para_shape_id, GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, page_num,          GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, image_num,         GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, table_num,         GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, math_num,          GHWP_U16),
+    GHWP_FIELD (GHWPSectionDef, lang,              GHWP_U16),
+};
+
 gboolean ghwp_parse_section_def (GHWPSection *sec, GHWPContext *ctx)
 {
     g_return_val_if_fail (sec != NULL, FALSE);
 
-    context_read_uint32 (ctx, &sec->def_info.attr);
-    context_read_hwp_unit16 (ctx, &sec->def_info.col_spacing);
-    context_read_hwp_unit16 (ctx, &sec->def_info.v_align);
-    context_read_hwp_unit16 (ctx, &sec->def_info.h_align);
-    context_read_hwp_unit (ctx, &sec->def_info.default_tab_size);
-    context_read_uint16 (ctx, &sec->def_info.num_para_shape_id);
-    context_read_uint16 (ctx, &sec->def_info.page_num);
-    context_read_uint16 (ctx, &sec->def_info.image_num);
-    context_read_uint16 (ctx, &sec->def_info.table_num);
-    context_read_uint16 (ctx, &sec->def_info.math_num);
-    context_read_uint16 (ctx, &sec->def_info.lang);
+    context_decode (ctx, section_def_fields,
+                    G_N_ELEMENTS (section_def_fields), &sec->def_info);
 
     return TRUE;
 }
 
+static const GHWPField page_def_fields[] = {
+    GHWP_FIELD (GHWPPageDef, h_size,   GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, v_size,   GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, l_margin, GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, r_margin, GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, t_margin, GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, b_margin, GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, header,   GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, footer,   GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, binding,  GHWP_U32),
+    GHWP_FIELD (GHWPPageDef, attr,     GHWP_U32),
+};
+
+/* 섹션 객체 없이 용지 설정만 읽는다 */
+gboolean ghwp_parse_page_def_info (GHWPPageDef *info, GHWPContext *ctx)
+{
+    g_return_val_if_fail (info != NULL, FALSE);
+
+    return context_decode (ctx, page_def_fields,
+                           G_N_ELEMENTS (page_def_fields), info);
+}
+
 gboolean ghwp_parse_page_def (GHWPSection *sec, GHWPContext *ctx)
 {
     g_return_val_if_fail (sec != NULL, FALSE);
 
-    context_read_hwp_unit (ctx, &sec->page_info.h_size);
-    context_read_hwp_unit (ctx, &sec->page_info.v_size);
-    context_read_hwp_unit (ctx, &sec->page_info.l_margin);
-    context_read_hwp_unit (ctx, &sec->page_info.r_margin);
-    context_read_hwp_unit (ctx, &sec->page_info.t_margin);
-    context_read_hwp_unit (ctx, &sec->page_info.b_margin);
-    context_read_hwp_unit (ctx, &sec->page_info.header);
-    context_read_hwp_unit (ctx, &sec->page_info.footer);
-    context_read_hwp_unit (ctx, &sec->page_info.binding);
-    context_read_uint32 (ctx, &sec->page_info.attr);
+    ghwp_parse_page_def_info (&sec->page_info, ctx);
 
     return TRUE;
 }
@@ -107,6 +107,8 @@ gboolean ghwp_parse_section_def      (GHWPSection *sec,
                                       GHWPContext *ctx);
 gboolean ghwp_parse_page_def         (GHWPSection *sec,
                                       GHWPContext *ctx);
+gboolean ghwp_parse_page_def_info    (GHWPPageDef *info,
+                                      GHWPContext *ctx);
 gboolean ghwp_parse_column_def       (GHWPSection *sec,
                                       GHWPContext *ctx);
 void     ghwp_section_add_paragraph  (GHWPSection *sec,
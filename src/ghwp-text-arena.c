@@ -0,0 +1,131 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-text-arena.c
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 섹션 하나의 문단 텍스트를 몇 개의 큰 블록에 차례로 담는다. 문단마다
+ * 따로 할당하지 않으므로 힙이 조각나지 않고, 문서를 닫을 때도 블록
+ * 몇 개만 해제한다. 할당은 섹션을 만드는 스레드 하나에서만 하고,
+ * 참조 카운트는 여러 스레드에서 바꿀 수 있다.
+ */
+
+#include "config.h"
+
+#include "ghwp-text-arena.h"
+
+/* 크기를 미리 알 수 없을 때 새로 만드는 블록의 크기 */
+#define ARENA_BLOCK_SIZE  (64 * 1024)
+#define ARENA_ALIGN       sizeof (guint32)
+
+struct _GHWPTextArena
+{
+    gint    ref_count;
+    GSList *blocks;
+    guint8 *pos;      /* 마지막 블록에서 비어 있는 곳 */
+    gsize   left;
+    GArray *scratch;  /* 제어 문자 위치를 모으는 임시 배열 */
+};
+
+static void arena_add_block (GHWPTextArena *arena, gsize size)
+{
+    guint8 *block = g_malloc (size);
+
+    arena->blocks = g_slist_prepend (arena->blocks, block);
+    arena->pos    = block;
+    arena->left   = size;
+}
+
+/**
+ * _ghwp_text_arena_new:
+ * @size_hint: the number of bytes expected to be allocated, or 0
+ *
+ * Returns: a new #GHWPTextArena, free with _ghwp_text_arena_unref()
+ */
+GHWPTextArena *_ghwp_text_arena_new (gsize size_hint)
+{
+    GHWPTextArena *arena = g_slice_new0 (GHWPTextArena);
+
+    arena->ref_count = 1;
+    arena_add_block (arena, MAX (size_hint, ARENA_BLOCK_SIZE / 16));
+
+    return arena;
+}
+
+GHWPTextArena *_ghwp_text_arena_ref (GHWPTextArena *arena)
+{
+    g_return_val_if_fail (arena != NULL, NULL);
+
+    g_atomic_int_inc (&arena->ref_count);
+    return arena;
+}
+
+void _ghwp_text_arena_unref (GHWPTextArena *arena)
+{
+    g_return_if_fail (arena != NULL);
+
+    if (!g_atomic_int_dec_and_test (&arena->ref_count))
+        return;
+
+    g_slist_free_full (arena->blocks, g_free);
+    if (arena->scratch)
+        g_array_free (arena->scratch, TRUE);
+    g_slice_free (GHWPTextArena, arena);
+}
+
+/**
+ * _ghwp_text_arena_alloc:
+ * @arena: a #GHWPTextArena
+ * @size: the number of bytes to allocate
+ *
+ * Allocates @size bytes aligned to 4 bytes. The memory is not cleared
+ * and stays valid until the last reference to @arena is dropped.
+ *
+ * Returns: the memory, or %NULL if @size is 0
+ */
+gpointer _ghwp_text_arena_alloc (GHWPTextArena *arena, gsize size)
+{
+    gpointer mem;
+
+    g_return_val_if_fail (arena != NULL, NULL);
+
+    if (size == 0)
+        return NULL;
+
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    if (size > arena->left)
+        arena_add_block (arena, MAX (size, ARENA_BLOCK_SIZE));
+
+    mem = arena->pos;
+    arena->pos  += size;
+    arena->left -= size;
+
+    return mem;
+}
+
+/* 할당하는 스레드에서만 쓸 수 있는 #guint32 배열, 쓰기 전에 비운다 */
+GArray *_ghwp_text_arena_get_scratch (GHWPTextArena *arena)
+{
+    g_return_val_if_fail (arena != NULL, NULL);
+
+    if (arena->scratch == NULL)
+        arena->scratch = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+    return arena->scratch;
+}
@@ -0,0 +1,43 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-text-arena.h
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
+ */
+
+#ifndef __GHWP_TEXT_ARENA_H__
+#define __GHWP_TEXT_ARENA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GHWPTextArena GHWPTextArena;
+
+GHWPTextArena *_ghwp_text_arena_new         (gsize          size_hint);
+GHWPTextArena *_ghwp_text_arena_ref         (GHWPTextArena *arena);
+void           _ghwp_text_arena_unref       (GHWPTextArena *arena);
+gpointer       _ghwp_text_arena_alloc       (GHWPTextArena *arena,
+                                             gsize          size);
+GArray        *_ghwp_text_arena_get_scratch (GHWPTextArena *arena);
+
+G_END_DECLS
+
+#endif /* __GHWP_TEXT_ARENA_H__ */
@@ -0,0 +1,324 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-text-writer.c
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 문단 텍스트를 GOutputStream 으로 바로 쓴다. v5 문서는 ghwp_document_walk
+ * 로 레코드를 읽으면서 쓰므로 페이지나 문단 객체를 만들지 않고, 쓰기
+ * 버퍼 말고는 문서 크기와 상관없는 메모리만 쓴다.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#include "ghwp-text-writer.h"
+#include "ghwp-document.h"
+#include "ghwp-file-v5.h"
+#include "ghwp-parse.h"
+#include "ghwp-visitor.h"
+#include "ghwp-utf16.h"
+
+/* 버퍼가 이만큼 차면 스트림에 쓴다 */
+#define WRITER_FLUSH_SIZE  (64 * 1024)
+
+/* 열려 있는 문단 */
+typedef struct
+{
+    guint8  included;      /* 이 문단의 텍스트를 쓴다 */
+    guint8  has_children;  /* 안에 쓴 문단이 있다 (표의 셀 등) */
+} WriterItem;
+
+typedef struct
+{
+    GOutputStream *out;
+    GCancellable  *cancellable;
+    GError        *error;
+    GHWPTextFlags  flags;
+    GString       *buf;
+    gunichar2     *units;       /* 정렬되지 않은 text_run 을 옮길 곳 */
+    guint          n_units;
+    gboolean       line_open;   /* 마지막 줄 바꿈 뒤에 쓴 글자가 있다 */
+    guint          depth;
+    WriterItem     stack[GHWP_MAX_STATE * 2];
+} GHWPTextWriter;
+
+static gboolean writer_flush (GHWPTextWriter *writer, gboolean force)
+{
+    if (writer->buf->len == 0 ||
+        (!force && writer->buf->len < WRITER_FLUSH_SIZE))
+        return TRUE;
+
+    if (!g_output_stream_write_all (writer->out, writer->buf->str,
+                                    writer->buf->len, NULL,
+                                    writer->cancellable, &writer->error))
+        return FALSE;
+
+    g_string_truncate (writer->buf, 0);
+    return TRUE;
+}
+
+static void writer_end_line (GHWPTextWriter *writer)
+{
+    const gchar *eol = (writer->flags & GHWP_TEXT_CRLF) ? "\r\n" : "\n";
+
+    g_string_append (writer->buf, eol);
+    if (writer->flags & GHWP_TEXT_BLANK_LINE)
+        g_string_append (writer->buf, eol);
+
+    writer->line_open = FALSE;
+}
+
+static inline gboolean writer_is_writing (GHWPTextWriter *writer)
+{
+    return writer->depth > 0 && writer->stack[writer->depth - 1].included;
+}
+
+static gboolean writer_paragraph_begin (const GHWPParagraphHeader *header,
+                                        GHWPScope                  scope,
+                                        guint                      level,
+                                        gpointer                   user_data)
+{
+    GHWPTextWriter *writer = user_data;
+    WriterItem     *item;
+    gboolean        included;
+
+    switch (scope) {
+    case GHWP_SCOPE_BODY:
+        included = TRUE;
+        break;
+    case GHWP_SCOPE_CELL:
+        included = (writer->flags & GHWP_TEXT_CELLS) != 0;
+        break;
+    case GHWP_SCOPE_CAPTION:
+        included = (writer->flags & GHWP_TEXT_CAPTIONS) != 0;
+        break;
+    default:
+        included = (writer->flags & GHWP_TEXT_OTHERS) != 0;
+        break;
+    }
+
+    g_return_val_if_fail (writer->depth < G_N_ELEMENTS (writer->stack), FALSE);
+
+    /* 쓰지 않는 문단 안에 있는 문단은 쓰지 않는다 */
+    if (writer->depth > 0 && !writer_is_writing (writer))
+        included = FALSE;
+
+    if (included && writer->depth > 0) {
+        writer->stack[writer->depth - 1].has_children = TRUE;
+        if (writer->line_open)
+            writer_end_line (writer);
+    }
+
+    item = &writer->stack[writer->depth++];
+    item->included     = included;
+    item->has_children = FALSE;
+
+    return TRUE;
+}
+
+static gboolean writer_paragraph_end (gpointer user_data)
+{
+    GHWPTextWriter *writer = user_data;
+    WriterItem     *item;
+
+    if (writer->depth == 0)
+        return TRUE;
+
+    item = &writer->stack[--writer->depth];
+
+    /* 빈 문단은 빈 줄로 쓰고, 표만 있던 문단은 줄을 더 바꾸지 않는다 */
+    if (item->included && (writer->line_open || !item->has_children))
+        writer_end_line (writer);
+
+    if (g_cancellable_set_error_if_cancelled (writer->cancellable,
+                                              &writer->error))
+        return FALSE;
+
+    return writer_flush (writer, FALSE);
+}
+
+static gboolean writer_text_run (const guint8 *utf16le,
+                                 guint         n_chars,
+                                 gpointer      user_data)
+{
+    GHWPTextWriter  *writer = user_data;
+    const gunichar2 *units;
+    guint            i;
+
+    if (!writer_is_writing (writer) || n_chars == 0)
+        return TRUE;
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    if (((gsize) utf16le & 1) == 0) {
+        units = (const gunichar2 *) utf16le;
+    } else
+#endif
+    {
+        if (n_chars > writer->n_units) {
+            writer->units   = g_renew (gunichar2, writer->units, n_chars);
+            writer->n_units = n_chars;
+        }
+        for (i = 0; i < n_chars; i++)
+            writer->units[i] = utf16le[i * 2] | (utf16le[i * 2 + 1] << 8);
+        units = writer->units;
+    }
+
+    _ghwp_utf16_append_utf8 (writer->buf, units, n_chars);
+    writer->line_open = TRUE;
+
+    return TRUE;
+}
+
+static gboolean writer_control (gunichar2 code,
+                                guint32   ctrl_id,
+                                guint     position,
+                                gpointer  user_data)
+{
+    GHWPTextWriter *writer = user_data;
+    const gchar    *str;
+
+    if (!writer_is_writing (writer))
+        return TRUE;
+
+    switch (code) {
+    case GHWP_CC_TAB:
+        str = "\t";
+        break;
+    case GHWP_CC_LINE_BREAK:
+        str = (writer->flags & GHWP_TEXT_CRLF) ? "\r\n" : "\n";
+        break;
+    case GHWP_CC_HYPHEN:
+        str = "-";
+        break;
+    case GHWP_CC_GROUP_SPACE:
+    case GHWP_CC_FIXED_SPACE:
+        str = " ";
+        break;
+    default:
+        /* 문단 끝은 paragraph_end 에서 쓴다 */
+        return TRUE;
+    }
+
+    g_string_append (writer->buf, str);
+    writer->line_open = TRUE;
+
+    return TRUE;
+}
+
+static const GHWPVisitor text_writer_visitor = {
+    NULL,                    /* section_begin */
+    NULL,                    /* section_end */
+    writer_paragraph_begin,
+    writer_paragraph_end,
+    writer_text_run,
+    writer_control,
+    NULL,                    /* table_begin */
+    NULL,                    /* table_cell */
+    NULL,                    /* table_end */
+    NULL                     /* picture */
+};
+
+/* v3, HWPML 문서는 문단을 모두 읽어 두므로 그 텍스트를 쓴다 */
+static gboolean writer_write_paragraphs (GHWPTextWriter *writer,
+                                         GHWPDocument   *doc)
+{
+    guint i;
+
+    for (i = 0; i < doc->paragraphs->len; i++) {
+        GHWPParagraph *paragraph;
+        const gchar   *text = NULL;
+        gsize          len;
+
+        paragraph = g_array_index (doc->paragraphs, GHWPParagraph *, i);
+        if (paragraph->ghwp_text)
+            text = ghwp_text_get_text (paragraph->ghwp_text);
+
+        len = text ? strlen (text) : 0;
+        while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r'))
+            len--;
+
+        g_string_append_len (writer->buf, text, len);
+        writer_end_line (writer);
+
+        if (g_cancellable_set_error_if_cancelled (writer->cancellable,
+                                                  &writer->error))
+            return FALSE;
+        if (!writer_flush (writer, FALSE))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * ghwp_document_write_text:
+ * @doc: a #GHWPDocument
+ * @out: a #GOutputStream to write to
+ * @flags: #GHWPTextFlags to choose what to write and how
+ * @cancellable: (allow-none): optional #GCancellable object, %NULL to ignore
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Writes the text of the paragraphs of @doc to @out as UTF-8, in
+ * document order, one paragraph per line. Inline and extended controls
+ * are left out; tabs, line breaks, hyphens and fixed spaces are written
+ * as plain characters.
+ *
+ * For HWP v5 documents the text is read straight from the body records,
+ * without building pages or paragraph objects, and the memory used does
+ * not grow with the size of the document.
+ *
+ * Returns: %FALSE if an error occurred, %TRUE otherwise
+ */
+gboolean ghwp_document_write_text (GHWPDocument  *doc,
+                                   GOutputStream *out,
+                                   GHWPTextFlags  flags,
+                                   GCancellable  *cancellable,
+                                   GError       **error)
+{
+    GHWPTextWriter *writer;
+    gboolean        ok;
+
+    g_return_val_if_fail (GHWP_IS_DOCUMENT (doc), FALSE);
+    g_return_val_if_fail (G_IS_OUTPUT_STREAM (out), FALSE);
+
+    writer = g_new0 (GHWPTextWriter, 1);
+    writer->out         = out;
+    writer->cancellable = cancellable;
+    writer->flags       = flags;
+    writer->buf         = g_string_sized_new (WRITER_FLUSH_SIZE + 4096);
+
+    if (GHWP_IS_FILE_V5 (doc->file))
+        ok = ghwp_document_walk (doc, &text_writer_visitor, writer, error);
+    else
+        ok = writer_write_paragraphs (writer, doc);
+
+    if (ok && writer->error == NULL)
+        writer_flush (writer, TRUE);
+
+    if (writer->error) {
+        g_propagate_error (error, writer->error);
+        ok = FALSE;
+    }
+
+    g_string_free (writer->buf, TRUE);
+    g_free (writer->units);
+    g_free (writer);
+
+    return ok;
+}
@@ -0,0 +1,266 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-utf16.c
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 문단 텍스트(UTF-16)를 UTF-8 로 바꾼다. 제어 문자를 찾는 일과 ASCII 를
+ * 바꾸는 일은 SSE2 (있으면 AVX2) 로 여러 글자씩 하고, 나머지는 한 글자씩
+ * 한다. 단위는 호스트 바이트 순서이다.
+ */
+
+#include "config.h"
+#include <string.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined (__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "ghwp-utf16.h"
+#include "ghwp-models.h"
+
+/* 제어 문자의 길이 (UTF-16 단위), 인라인과 확장 제어 문자 */
+#define CONTROL_LEN  8
+
+/**
+ * _ghwp_utf16_find_control:
+ * @units: UTF-16 code units in host byte order
+ * @n_units: number of units in @units
+ *
+ * Returns: the index of the first unit below %GHWP_NUM_CC, or @n_units
+ */
+gsize _ghwp_utf16_find_control (const gunichar2 *units, gsize n_units)
+{
+    gsize i = 0;
+
+    /* (ch & ~0x1f) == 0 이면 제어 문자이다 */
+#if defined (__AVX2__)
+    {
+        const __m256i mask = _mm256_set1_epi16 ((short) 0xffe0);
+        const __m256i zero = _mm256_setzero_si256 ();
+
+        for (; i + 16 <= n_units; i += 16) {
+            __m256i v = _mm256_loadu_si256 ((const __m256i *) (units + i));
+            guint32 m = (guint32) _mm256_movemask_epi8 (
+                            _mm256_cmpeq_epi16 (_mm256_and_si256 (v, mask),
+                                                zero));
+            if (m)
+                return i + g_bit_nth_lsf (m, -1) / 2;
+        }
+    }
+#endif
+#if defined (__SSE2__)
+    {
+        const __m128i mask = _mm_set1_epi16 ((short) 0xffe0);
+        const __m128i zero = _mm_setzero_si128 ();
+
+        for (; i + 8 <= n_units; i += 8) {
+            __m128i v = _mm_loadu_si128 ((const __m128i *) (units + i));
+            guint32 m = (guint32) _mm_movemask_epi8 (
+                            _mm_cmpeq_epi16 (_mm_and_si128 (v, mask), zero));
+            if (m)
+                return i + g_bit_nth_lsf (m, -1) / 2;
+        }
+    }
+#endif
+
+    for (; i < n_units; i++) {
+        if (units[i] < GHWP_NUM_CC)
+            return i;
+    }
+
+    return n_units;
+}
+
+/* 한 글자를 바꾼다. 짝이 맞는 대리 쌍은 두 단위를 읽고, 짝이 없는
+ * 대리 단위는 U+FFFD 로 바꾼다. 읽은 단위의 수를 반환한다. */
+static inline gsize
+utf16_encode_one (guchar **out, const gunichar2 *units, gsize n_units)
+{
+    guchar  *p = *out;
+    gunichar c = units[0];
+    gsize    used = 1;
+
+    if (c >= 0xd800 && c <= 0xdfff) {
+        if (c <= 0xdbff && n_units > 1 &&
+            units[1] >= 0xdc00 && units[1] <= 0xdfff) {
+            c = 0x10000 + ((c - 0xd800) << 10) + (units[1] - 0xdc00);
+            used = 2;
+        } else {
+            c = 0xfffd;
+        }
+    }
+
+    if (c < 0x80) {
+        *p++ = (guchar) c;
+    } else if (c < 0x800) {
+        *p++ = (guchar) (0xc0 | (c >> 6));
+        *p++ = (guchar) (0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+        *p++ = (guchar) (0xe0 | (c >> 12));
+        *p++ = (guchar) (0x80 | ((c >> 6) & 0x3f));
+        *p++ = (guchar) (0x80 | (c & 0x3f));
+    } else {
+        *p++ = (guchar) (0xf0 | (c >> 18));
+        *p++ = (guchar) (0x80 | ((c >> 12) & 0x3f));
+        *p++ = (guchar) (0x80 | ((c >> 6) & 0x3f));
+        *p++ = (guchar) (0x80 | (c & 0x3f));
+    }
+
+    *out = p;
+    return used;
+}
+
+/* 한 단위는 UTF-8 로 많아야 3 바이트이다 (대리 쌍은 2 단위에 4 바이트) */
+static guchar *utf16_encode_run (guchar          *p,
+                                 const gunichar2 *units,
+                                 gsize            n_units)
+{
+    gsize i = 0;
+
+    while (i < n_units) {
+        gsize end = MIN (i + 8, n_units);
+
+#if defined (__SSE2__)
+        /* 8 글자가 모두 ASCII 이면 한 번에 바이트로 줄인다 */
+        if (end - i == 8) {
+            __m128i v = _mm_loadu_si128 ((const __m128i *) (units + i));
+            __m128i high = _mm_and_si128 (v, _mm_set1_epi16 ((short) 0xff80));
+
+            if (_mm_movemask_epi8 (_mm_cmpeq_epi16 (high,
+                                                    _mm_setzero_si128 ())) ==
+                0xffff) {
+                _mm_storel_epi64 ((__m128i *) p, _mm_packus_epi16 (v, v));
+                p += 8;
+                i += 8;
+                continue;
+            }
+        }
+#endif
+
+        while (i < end)
+            i += utf16_encode_one (&p, units + i, n_units - i);
+    }
+
+    return p;
+}
+
+/**
+ * _ghwp_utf16_append_utf8:
+ * @str: a #GString to append to
+ * @units: UTF-16 code units in host byte order
+ * @n_units: number of units in @units
+ *
+ * Appends @units to @str as UTF-8. Unpaired surrogates become U+FFFD.
+ */
+void _ghwp_utf16_append_utf8 (GString         *str,
+                              const gunichar2 *units,
+                              gsize            n_units)
+{
+    gsize   len = str->len;
+    guchar *end;
+
+    g_string_set_size (str, len + n_units * 3);
+    end = utf16_encode_run ((guchar *) str->str + len, units, n_units);
+    g_string_truncate (str, (gsize) (end - (guchar *) str->str));
+}
+
+/**
+ * _ghwp_utf16_decode_text:
+ * @str: a #GString to append to
+ * @units: the UTF-16 code units of a PARA_TEXT record in host byte order
+ * @n_units: number of units in @units
+ * @controls: (allow-none): a #GArray of #guint to add the positions of
+ *     the inline and extended controls to, or %NULL
+ *
+ * Appends the text of a paragraph to @str as UTF-8. Inline and extended
+ * controls take 8 units and are left out; their positions (in units)
+ * are added to @controls. Char controls are copied as they are.
+ */
+void _ghwp_utf16_decode_text (GString         *str,
+                              const gunichar2 *units,
+                              gsize            n_units,
+                              GArray          *controls)
+{
+    gsize   len = str->len;
+    guchar *p;
+    gsize   i = 0;
+
+    g_string_set_size (str, len + n_units * 3);
+    p = (guchar *) str->str + len;
+
+    while (i < n_units) {
+        gsize     run = _ghwp_utf16_find_control (units + i, n_units - i);
+        gunichar2 ch;
+
+        p  = utf16_encode_run (p, units + i, run);
+        i += run;
+        if (i == n_units)
+            break;
+
+        ch = units[i];
+        if (ghwp_control_char_type[ch] == GHWP_CC_TYPE_CHAR) {
+            *p++ = (guchar) ch;
+            i++;
+            continue;
+        }
+
+        if (controls) {
+            guint pos = (guint) i;
+            g_array_append_val (controls, pos);
+        }
+        i += CONTROL_LEN;
+    }
+
+    g_string_truncate (str, (gsize) (p - (guchar *) str->str));
+}
+
+/**
+ * _ghwp_utf16_scan_controls:
+ * @units: the UTF-16 code units of a PARA_TEXT record in host byte order
+ * @n_units: number of units in @units
+ * @controls: a #GArray of #guint32 to add the positions to
+ *
+ * Adds the positions of the inline and extended controls in @units to
+ * @controls without decoding the text.
+ */
+void _ghwp_utf16_scan_controls (const gunichar2 *units,
+                                gsize            n_units,
+                                GArray          *controls)
+{
+    gsize   i = 0;
+    guint32 pos;
+
+    while (i < n_units) {
+        i += _ghwp_utf16_find_control (units + i, n_units - i);
+        if (i == n_units)
+            break;
+
+        if (ghwp_control_char_type[units[i]] == GHWP_CC_TYPE_CHAR) {
+            i++;
+            continue;
+        }
+
+        pos = (guint32) i;
+        g_array_append_val (controls, pos);
+        i += CONTROL_LEN;
+    }
+}
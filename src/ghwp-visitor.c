@@ -0,0 +1,343 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-visitor.c
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 문서 객체를 만들지 않고 레코드를 읽으면서 바로 콜백을 부른다.
+ * 걷기 상태와 섹션마다의 컨텍스트 말고는 메모리를 할당하지 않는다.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <gio/gio.h>
+
+#include "ghwp-visitor.h"
+#include "ghwp-file-v5.h"
+#include "ghwp-parse.h"
+#include "ghwp-private.h"
+
+#define _g_object_unref0(var) ((var == NULL) ? NULL : (var = (g_object_unref (var), NULL)))
+
+/* 표 76 그림 개체 속성에서 binitem_id 의 위치 */
+#define PICTURE_BINITEM_ID_OFFSET  71
+
+#define CTRL_ID_TABLE  GUINT32_FROM_LE(MAKE_CTRL_ID('t', 'b', 'l', ' '))
+
+typedef enum
+{
+    WALK_PARAGRAPH,
+    WALK_TABLE
+} WalkKind;
+
+/* 열려 있는 문단 또는 표 */
+typedef struct
+{
+    guint16   level;
+    guint8    kind;
+    guint8    table_begun;  /* 표: TABLE 레코드를 읽었다 */
+} WalkItem;
+
+typedef struct
+{
+    const GHWPVisitor *visitor;
+    gpointer           user_data;
+    guint              depth;
+    WalkItem           stack[GHWP_MAX_STATE * 2];
+} GHWPWalker;
+
+static inline guint16 read_uint16 (const guint8 *p)
+{
+    return (guint16) (p[0] | (p[1] << 8));
+}
+
+static inline guint32 read_uint32 (const guint8 *p)
+{
+    return (guint32) p[0]         | ((guint32) p[1] <<  8) |
+           ((guint32) p[2] << 16) | ((guint32) p[3] << 24);
+}
+
+static void walker_push (GHWPWalker *walker, guint16 level, WalkKind kind)
+{
+    WalkItem *item;
+
+    g_return_if_fail (walker->depth < G_N_ELEMENTS (walker->stack));
+
+    item = &walker->stack[walker->depth++];
+    item->level       = level;
+    item->kind        = kind;
+    item->table_begun = FALSE;
+}
+
+static inline WalkItem *walker_top (GHWPWalker *walker)
+{
+    return walker->depth > 0 ? &walker->stack[walker->depth - 1] : NULL;
+}
+
+/* level 보다 깊거나 같은 문단과 표를 닫는다 */
+static gboolean walker_close (GHWPWalker *walker, guint level)
+{
+    const GHWPVisitor *v = walker->visitor;
+
+    while (walker->depth > 0 && walker->stack[walker->depth - 1].level >= level) {
+        WalkItem *item = &walker->stack[--walker->depth];
+
+        if (item->kind == WALK_PARAGRAPH) {
+            if (v->paragraph_end && !v->paragraph_end (walker->user_data))
+                return FALSE;
+        } else if (item->table_begun) {
+            if (v->table_end && !v->table_end (walker->user_data))
+                return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* 글자를 제어 문자 앞뒤로 잘라서 보낸다 */
+static gboolean walker_text (GHWPWalker *walker, GHWPContext *context)
+{
+    const GHWPVisitor *v = walker->visitor;
+    const guint8      *data;
+    guint              n_chars = context->data_len / 2;
+    guint              start = 0;
+    guint              i;
+
+    data = context_read_ptr (context, n_chars * 2);
+    if (data == NULL)
+        return TRUE;
+
+    for (i = 0; i < n_chars; i++) {
+        gunichar2 ch = read_uint16 (data + i * 2);
+        guint32   ctrl_id = 0;
+
+        if (ch >= GHWP_NUM_CC)
+            continue;
+
+        if (i > start && v->text_run &&
+            !v->text_run (data + start * 2, i - start, walker->user_data))
+            return FALSE;
+
+        if (ghwp_control_char_type[ch] != GHWP_CC_TYPE_CHAR && i + 3 <= n_chars)
+            ctrl_id = read_uint32 (data + (i + 1) * 2);
+
+        if (v->control && !v->control (ch, ctrl_id, i, walker->user_data))
+            return FALSE;
+
+        /* 인라인, 확장 제어 문자는 8 글자를 차지한다 */
+        if (ghwp_control_char_type[ch] != GHWP_CC_TYPE_CHAR)
+            i += 7;
+
+        start = i + 1;
+    }
+
+    if (start < n_chars && v->text_run &&
+        !v->text_run (data + start * 2, n_chars - start, walker->user_data))
+        return FALSE;
+
+    return TRUE;
+}
+
+static gboolean walker_record (GHWPWalker *walker, GHWPContext *context)
+{
+    const GHWPVisitor  *v = walker->visitor;
+    WalkItem           *top;
+    GHWPParagraphHeader header;
+    GHWPListHeader      lhdr;
+    GHWPScope           scope;
+    guint32             ctrl_id;
+    guint32             flags;
+    guint16             n_rows, n_cols;
+    guint16             col, row, col_span, row_span;
+    guint16             binitem_id;
+
+    /* 문단의 데이터는 문단보다 한 단계 깊다. 그렇지 않은 레코드가
+     * 나오면 열려 있던 문단과 표가 끝난 것이다. */
+    if (!walker_close (walker, context->level))
+        return FALSE;
+
+    top = walker_top (walker);
+
+    switch (context->tag_id) {
+    case GHWP_TAG_PARA_HEADER:
+        if (context->level == 0)
+            scope = GHWP_SCOPE_BODY;
+        else if (top && top->kind == WALK_TABLE && top->level + 1 == context->level)
+            scope = top->table_begun ? GHWP_SCOPE_CELL : GHWP_SCOPE_CAPTION;
+        else
+            scope = GHWP_SCOPE_OTHER;
+
+        memset (&header, 0, sizeof (header));
+        ghwp_parse_paragraph_header_data (&header, context);
+        walker_push (walker, context->level, WALK_PARAGRAPH);
+
+        if (v->paragraph_begin &&
+            !v->paragraph_begin (&header, scope, context->level,
+                                 walker->user_data))
+            return FALSE;
+        break;
+
+    case GHWP_TAG_PARA_TEXT:
+        if (top && top->kind == WALK_PARAGRAPH &&
+            top->level + 1 == context->level)
+            return walker_text (walker, context);
+        break;
+
+    case GHWP_TAG_CTRL_HEADER:
+        if (context_read_uint32 (context, &ctrl_id) && ctrl_id == CTRL_ID_TABLE)
+            walker_push (walker, context->level, WALK_TABLE);
+        break;
+
+    case GHWP_TAG_TABLE:
+        if (top == NULL || top->kind != WALK_TABLE ||
+            top->level + 1 != context->level || top->table_begun)
+            break;
+
+        if (!context_read_uint32 (context, &flags) ||
+            !context_read_uint16 (context, &n_rows) ||
+            !context_read_uint16 (context, &n_cols))
+            break;
+
+        top->table_begun = TRUE;
+
+        if (v->table_begin &&
+            !v->table_begin (n_rows, n_cols, walker->user_data))
+            return FALSE;
+        break;
+
+    case GHWP_TAG_LIST_HEADER:
+        if (top == NULL || top->kind != WALK_TABLE ||
+            top->level + 1 != context->level || !top->table_begun)
+            break;
+
+        /* 표 75 */
+        ghwp_parse_list_header (&lhdr, context);
+        if (!context_read_uint16 (context, &col)      ||
+            !context_read_uint16 (context, &row)      ||
+            !context_read_uint16 (context, &col_span) ||
+            !context_read_uint16 (context, &row_span))
+            break;
+
+        if (v->table_cell &&
+            !v->table_cell (row, col, row_span, col_span, walker->user_data))
+            return FALSE;
+        break;
+
+    case GHWP_TAG_SHAPE_COMPONENT_PICTURE:
+        if (!context_skip (context, PICTURE_BINITEM_ID_OFFSET) ||
+            !context_read_uint16 (context, &binitem_id))
+            break;
+
+        if (v->picture && !v->picture (binitem_id, walker->user_data))
+            return FALSE;
+        break;
+
+    default:
+        break;
+    }
+
+    return TRUE;
+}
+
+/**
+ * ghwp_document_walk:
+ * @doc: a #GHWPDocument
+ * @visitor: callbacks to call, any of which may be %NULL
+ * @user_data: data to pass to the callbacks
+ * @error: (allow-none): Return location for an error, or %NULL
+ *
+ * Walks the body of @doc and calls @visitor for each section, paragraph,
+ * text run, control, table, table cell and picture, in document order.
+ * Unlike the page model, no objects are built for the walk and the data
+ * passed to the callbacks is borrowed, so memory use does not grow with
+ * the size of the document. A callback may return %FALSE to stop early.
+ *
+ * Only HWP v5 documents are supported.
+ *
+ * Returns: %FALSE if an error occurred, %TRUE otherwise
+ */
+gboolean ghwp_document_walk (GHWPDocument      *doc,
+                             const GHWPVisitor *visitor,
+                             gpointer           user_data,
+                             GError           **error)
+{
+    GHWPFileV5 *file;
+    GHWPWalker *walker;
+    gboolean    stopped = FALSE;
+    guint       index;
+
+    g_return_val_if_fail (GHWP_IS_DOCUMENT (doc), FALSE);
+    g_return_val_if_fail (visitor != NULL, FALSE);
+
+    if (!GHWP_IS_FILE_V5 (doc->file)) {
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                             "Walking is supported only for HWP v5 documents");
+        return FALSE;
+    }
+
+    file   = GHWP_FILE_V5 (doc->file);
+    walker = g_new0 (GHWPWalker, 1);
+    walker->visitor   = visitor;
+    walker->user_data = user_data;
+
+    for (index = 0; !stopped && index < ghwp_file_v5_get_n_sections (file);
+         index++) {
+        GBytes      *section_data;
+        GHWPContext *context;
+        GError      *tmp_error = NULL;
+
+        section_data = _ghwp_file_v5_ref_section_data (file, index, error);
+        if (section_data == NULL) {
+            g_free (walker);
+            return FALSE;
+        }
+
+        context = ghwp_context_new_from_bytes (section_data);
+        context->version[0] = file->major_version;
+        context->version[1] = file->minor_version;
+        context->version[2] = file->micro_version;
+        context->version[3] = file->extra_version;
+        walker->depth = 0;
+
+        if (visitor->section_begin && !visitor->section_begin (index, user_data))
+            stopped = TRUE;
+
+        while (!stopped && ghwp_context_pull (context, &tmp_error)) {
+            if (!walker_record (walker, context))
+                stopped = TRUE;
+        }
+
+        _g_object_unref0 (context);
+        g_bytes_unref (section_data);
+
+        if (tmp_error) {
+            g_propagate_error (error, tmp_error);
+            g_free (walker);
+            return FALSE;
+        }
+
+        if (!stopped && !walker_close (walker, 0))
+            stopped = TRUE;
+        if (!stopped && visitor->section_end &&
+            !visitor->section_end (index, user_data))
+            stopped = TRUE;
+    }
+
+    g_free (walker);
+    return TRUE;
+}
@@ -0,0 +1,93 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * ghwp-visitor.h
+ *
+ * Copyright (C) 2018 Namhyung Kim <namhyung@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * 한글과컴퓨터의 한/글 문서 파일(.hwp) 공개 문서를 참고하여 개발하였습니다.
+ */
+
+#ifndef __GHWP_VISITOR_H__
+#define __GHWP_VISITOR_H__
+
+#include <glib-object.h>
+
+#include "ghwp.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GHWPVisitor GHWPVisitor;
+
+/* 문단이 놓인 곳 */
+typedef enum
+{
+    GHWP_SCOPE_BODY,     /* 본문 */
+    GHWP_SCOPE_CELL,     /* 표의 셀 */
+    GHWP_SCOPE_CAPTION,  /* 표의 캡션 */
+    GHWP_SCOPE_OTHER     /* 머리말, 꼬리말, 각주, 글상자 등 */
+} GHWPScope;
+
+/*
+ * 모든 콜백은 NULL 일 수 있다. FALSE 를 반환하면 거기서 멈춘다.
+ * 콜백에 넘기는 데이터는 콜백이 끝날 때까지만 유효하다.
+ *
+ * text_run: UTF-16LE 문자열, 정렬되어 있지 않을 수 있다.
+ *           제어 문자는 포함하지 않으며 control 로 따로 알린다.
+ * control:  code 는 제어 문자 (0 - 31), ctrl_id 는 인라인/확장 제어
+ *           문자일 때의 컨트롤 ID, 문자 제어 문자이면 0 이다.
+ *           position 은 문단 안에서 UTF-16 단위의 위치이다.
+ */
+struct _GHWPVisitor
+{
+    gboolean (*section_begin)   (guint                      index,
+                                 gpointer                   user_data);
+    gboolean (*section_end)     (guint                      index,
+                                 gpointer                   user_data);
+    gboolean (*paragraph_begin) (const GHWPParagraphHeader *header,
+                                 GHWPScope                  scope,
+                                 guint                      level,
+                                 gpointer                   user_data);
+    gboolean (*paragraph_end)   (gpointer                   user_data);
+    gboolean (*text_run)        (const guint8              *utf16le,
+                                 guint                      n_chars,
+                                 gpointer                   user_data);
+    gboolean (*control)         (gunichar2                  code,
+                                 guint32                    ctrl_id,
+                                 guint                      position,
+                                 gpointer                   user_data);
+    gboolean (*table_begin)     (guint16                    n_rows,
+                                 guint16                    n_cols,
+                                 gpointer                   user_data);
+    gboolean (*table_cell)      (guint16                    row,
+                                 guint16                    col,
+                                 guint16                    row_span,
+                                 guint16                    col_span,
+                                 gpointer                   user_data);
+    gboolean (*table_end)       (gpointer                   user_data);
+    gboolean (*picture)         (guint16                    binitem_id,
+                                 gpointer                   user_data);
+};
+
+gboolean ghwp_document_walk (GHWPDocument      *doc,
+                             const GHWPVisitor *visitor,
+                             gpointer           user_data,
+                             GError           **error);
+
+G_END_DECLS
+
+#endif /* __GHWP_VISITOR_H__ */
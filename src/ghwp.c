@@ -18,7 +18,9 @@
  */
 
 #include "config.h"
+#include <glib/gi18n-lib.h>
 #include "ghwp.h"
+#include "ghwp-private.h"
 
 /**
  * ghwp_error_quark:
@@ -65,6 +67,54 @@ _ghwp_get_tag_name (guint tag_id)
     return tag->value_name;
 }
 
+/* 스트림을 count 바이트 건너뛴다. 탐색 가능한 스트림이면 skip_fn 으로
+ * 위치만 옮기고, 압축된 스트림처럼 탐색할 수 없으면 호출자의 고정 크기
+ * 버퍼로 읽어 버린다. 어느 쪽이든 메모리를 할당하지 않는다. */
+gboolean
+_ghwp_input_stream_skip (GInputStream *stream,
+                         gsize         count,
+                         guint8       *scratch,
+                         gsize         scratch_size,
+                         GCancellable *cancellable,
+                         GError      **error)
+{
+    gsize bytes_read;
+
+    g_return_val_if_fail (G_IS_INPUT_STREAM (stream), FALSE);
+    g_return_val_if_fail (scratch != NULL && scratch_size > 0, FALSE);
+
+    if (G_IS_SEEKABLE (stream) && g_seekable_can_seek (G_SEEKABLE (stream))) {
+        gssize skipped = g_input_stream_skip (stream, count, cancellable,
+                                              error);
+
+        if (skipped < 0)
+            return FALSE;
+
+        if ((gsize) skipped != count) {
+            g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                                 _("File corrupted"));
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    while (count > 0) {
+        if (!g_input_stream_read_all (stream, scratch,
+                                      MIN (count, scratch_size),
+                                      &bytes_read, cancellable, error))
+            return FALSE;
+
+        if (bytes_read == 0) {
+            g_set_error_literal (error, GHWP_ERROR, GHWP_ERROR_INVALID,
+                                 _("File corrupted"));
+            return FALSE;
+        }
+        count -= bytes_read;
+    }
+
+    return TRUE;
+}
+
 GType
 ghwp_error_get_type (void)
 {
@@ -70,6 +70,63 @@ typedef enum
     GHWP_ERROR_DAMAGED
 } GHWPError;
 
+/**
+ * GHWPOpenFlags:
+ * @GHWP_OPEN_NONE: No flags
+ * @GHWP_OPEN_PARALLEL: Decompress and parse the sections of the body
+ *     text on a thread pool, instead of one after another
+ * @GHWP_OPEN_METADATA_ONLY: Read only the file header, the summary
+ *     information and the preview of the file. The body text, binary
+ *     data and document info are never opened, so the document has no
+ *     pages. Only HWP v5 files honor this flag.
+ *
+ * Flags to control how a document is loaded
+ */
+typedef enum
+{
+    GHWP_OPEN_NONE          = 0,
+    GHWP_OPEN_PARALLEL      = 1 << 0,
+    GHWP_OPEN_METADATA_ONLY = 1 << 1
+} GHWPOpenFlags;
+
+/**
+ * GHWPTextFlags:
+ * @GHWP_TEXT_NONE: Write only the paragraphs of the body, one per line
+ * @GHWP_TEXT_CELLS: Also write the paragraphs in table cells
+ * @GHWP_TEXT_CAPTIONS: Also write the captions of tables
+ * @GHWP_TEXT_OTHERS: Also write headers, footers, footnotes, endnotes
+ *     and text boxes
+ * @GHWP_TEXT_CRLF: End paragraphs with "\r\n" instead of "\n"
+ * @GHWP_TEXT_BLANK_LINE: Put an empty line between paragraphs
+ *
+ * Flags to control what ghwp_document_write_text() writes. Only HWP v5
+ * documents tell the body from cells, captions and others; for other
+ * documents every paragraph is written.
+ */
+typedef enum
+{
+    GHWP_TEXT_NONE       = 0,
+    GHWP_TEXT_CELLS      = 1 << 0,
+    GHWP_TEXT_CAPTIONS   = 1 << 1,
+    GHWP_TEXT_OTHERS     = 1 << 2,
+    GHWP_TEXT_CRLF       = 1 << 3,
+    GHWP_TEXT_BLANK_LINE = 1 << 4
+} GHWPTextFlags;
+
+/**
+ * GHWPProgressFunc:
+ * @bytes_read: bytes of the body text read from the file so far
+ * @n_sections_done: number of sections parsed so far
+ * @n_sections: number of sections in the document
+ * @user_data: user data passed to the callback
+ *
+ * Called while a document is loaded to report how far it has got.
+ */
+typedef void (*GHWPProgressFunc) (guint64  bytes_read,
+                                  guint    n_sections_done,
+                                  guint    n_sections,
+                                  gpointer user_data);
+
 /**
  * GHWPSelectionStyle:
  * @GHWP_SELECTION_GLYPH: glyph is the minimum unit for selection
@@ -162,17 +219,25 @@ typedef struct _GHWPRectangle GHWPRectangle;
 typedef struct _GHWPContext   GHWPContext;
 typedef struct _GHWPSection   GHWPSection;
 typedef struct _GHWPParagraph GHWPParagraph;
+typedef struct _GHWPRecord    GHWPRecord;
+typedef struct _GHWPRecordIndex GHWPRecordIndex;
+typedef struct _GHWPSearchIndex GHWPSearchIndex;
 
 G_END_DECLS
 
 #define __GHWP_H_INSIDE__
 
+#include "ghwp-cache.h"
 #include "ghwp-document.h"
 #include "ghwp-file.h"
 #include "ghwp-models.h"
 #include "ghwp-page.h"
+#include "ghwp-record-index.h"
+#include "ghwp-search-index.h"
 #include "ghwp-section.h"
+#include "ghwp-text-writer.h"
 #include "ghwp-version.h"
+#include "ghwp-visitor.h"
 #include "gsf-input-stream.h"
 
 #undef __GHWP_H_INSIDE__
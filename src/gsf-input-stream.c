@@ -25,13 +25,21 @@
 
 #include "gsf-input-stream.h"
 
-G_DEFINE_TYPE (GsfInputStream, gsf_input_stream, G_TYPE_INPUT_STREAM);
+static void gsf_input_stream_seekable_iface_init (GSeekableIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GsfInputStream, gsf_input_stream, G_TYPE_INPUT_STREAM,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_SEEKABLE,
+                                                gsf_input_stream_seekable_iface_init));
 
 static gssize gsf_input_stream_read    (GInputStream *base,
                                         void         *buffer,
                                         gsize         buffer_len,
                                         GCancellable *cancellable,
                                         GError      **error);
+static gssize gsf_input_stream_skip    (GInputStream *base,
+                                        gsize         count,
+                                        GCancellable *cancellable,
+                                        GError      **error);
 static gboolean gsf_input_stream_close (GInputStream *base,
                                         GCancellable *cancellable,
                                         GError      **error);
@@ -54,14 +62,137 @@ static gssize gsf_input_stream_read (GInputStream *base,
                                      GError      **error)
 {
     GsfInputStream *gis = GSF_INPUT_STREAM (base);
-    gint64    remaining = gsf_input_remaining (gis->priv->input);
+    gsf_off_t remaining = gsf_input_remaining (gis->priv->input);
+    gsize     count     = buffer_len;
+
+    if ((gsf_off_t) count > remaining)
+        count = (gsize) remaining;
+
+    if (count > 0 && gsf_input_read (gis->priv->input, count, buffer) == NULL) {
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "gsf_input_read failed");
+        return -1;
+    }
+
+    return (gssize) count;
+}
+
+/**
+ * gsf_input_stream_borrow:
+ * @gis: a #GsfInputStream
+ * @len: number of bytes to read
+ *
+ * Reads @len bytes like g_input_stream_read(), but instead of copying
+ * them returns a pointer into the buffer of the underlying #GsfInput.
+ * For an input backed by memory it points into that memory. The data is
+ * valid until the next read from @gis.
+ *
+ * Returns: the data, or %NULL if fewer than @len bytes remain
+ */
+const guint8 *gsf_input_stream_borrow (GsfInputStream *gis, gsize len)
+{
+    g_return_val_if_fail (GSF_IS_INPUT_STREAM (gis), NULL);
+
+    if (gsf_input_remaining (gis->priv->input) < (gsf_off_t) len)
+        return NULL;
+
+    return gsf_input_read (gis->priv->input, len, NULL);
+}
+
+/* GsfInput 은 임의 접근이 가능하므로 읽지 않고 위치만 옮긴다. */
+static gssize gsf_input_stream_skip (GInputStream *base,
+                                     gsize         count,
+                                     GCancellable *cancellable,
+                                     GError      **error)
+{
+    GsfInputStream *gis = GSF_INPUT_STREAM (base);
+    gsf_off_t remaining = gsf_input_remaining (gis->priv->input);
+
+    if ((gsf_off_t) count > remaining)
+        count = (gsize) remaining;
 
-    if (remaining < (gint64) buffer_len) {
-        gsf_input_read (gis->priv->input, (gsize) remaining,  buffer);
-    } else {
-        gsf_input_read (gis->priv->input, (gsize) buffer_len, buffer);
+    /* gsf_input_seek 는 실패하면 TRUE 를 반환한다 */
+    if (gsf_input_seek (gis->priv->input, (gsf_off_t) count, G_SEEK_CUR)) {
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "gsf_input_seek failed");
+        return -1;
     }
-    return (gssize) (remaining - gsf_input_remaining (gis->priv->input));
+
+    return (gssize) count;
+}
+
+static goffset gsf_input_stream_tell (GSeekable *seekable)
+{
+    GsfInputStream *gis = GSF_INPUT_STREAM (seekable);
+    return (goffset) gsf_input_tell (gis->priv->input);
+}
+
+static gboolean gsf_input_stream_can_seek (GSeekable *seekable)
+{
+    return TRUE;
+}
+
+static gboolean gsf_input_stream_seek (GSeekable    *seekable,
+                                       goffset       offset,
+                                       GSeekType     type,
+                                       GCancellable *cancellable,
+                                       GError      **error)
+{
+    GsfInputStream *gis = GSF_INPUT_STREAM (seekable);
+    gsf_off_t       pos;
+
+    switch (type) {
+    case G_SEEK_SET:
+        pos = offset;
+        break;
+    case G_SEEK_CUR:
+        pos = gsf_input_tell (gis->priv->input) + offset;
+        break;
+    case G_SEEK_END:
+        pos = gsf_input_size (gis->priv->input) + offset;
+        break;
+    default:
+        g_assert_not_reached ();
+    }
+
+    if (pos < 0 || pos > gsf_input_size (gis->priv->input)) {
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                             "Invalid seek request");
+        return FALSE;
+    }
+
+    if (gsf_input_seek (gis->priv->input, pos, G_SEEK_SET)) {
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "gsf_input_seek failed");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean gsf_input_stream_can_truncate (GSeekable *seekable)
+{
+    return FALSE;
+}
+
+static gboolean gsf_input_stream_truncate (GSeekable    *seekable,
+                                           goffset       offset,
+                                           GCancellable *cancellable,
+                                           GError      **error)
+{
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                         "Cannot truncate GsfInputStream");
+    return FALSE;
+}
+
+static void
+gsf_input_stream_seekable_iface_init (GSeekableIface *iface)
+{
+    iface->tell         = gsf_input_stream_tell;
+    iface->can_seek     = gsf_input_stream_can_seek;
+    iface->seek         = gsf_input_stream_seek;
+    iface->can_truncate = gsf_input_stream_can_truncate;
+    iface->truncate_fn  = gsf_input_stream_truncate;
 }
 
 static gboolean
@@ -86,6 +217,7 @@ gsf_input_stream_class_init (GsfInputStreamClass *klass)
     GInputStreamClass *parent_class = G_INPUT_STREAM_CLASS (klass);
     g_type_class_add_private (klass, sizeof (GsfInputStreamPrivate));
     parent_class->read_fn  = gsf_input_stream_read;
+    parent_class->skip_fn  = gsf_input_stream_skip;
     parent_class->close_fn = gsf_input_stream_close;
     object_class->finalize = gsf_input_stream_finalize;
 }
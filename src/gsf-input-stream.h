@@ -52,6 +52,8 @@ struct _GsfInputStreamPrivate {
 GType           gsf_input_stream_get_type (void) G_GNUC_CONST;
 GsfInputStream *gsf_input_stream_new      (GsfInput       *input);
 gssize          gsf_input_stream_size     (GsfInputStream *gsf_input_stream);
+const guint8   *gsf_input_stream_borrow   (GsfInputStream *gis,
+                                           gsize           len);
 
 G_END_DECLS
 